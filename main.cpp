@@ -8,340 +8,4312 @@
 #include <limits>
 #include <chrono>
 #include <ctime>
+#include <unordered_map>
+#include <cctype>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <string_view>
+#include <charconv>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <random>
+#include <condition_variable>
+#include <queue>
+#include <functional>
+#include <variant>
+#include <array>
+#include <tuple>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <csignal>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 using namespace std;
 
+// Buferizuota isvestis: eilutes formuojamos pakartotinai naudojamame buferyje
+// ir i srauta rasomos dideliais gabalais, o ne po viena eilute
+class OutputBuffer {
+private:
+    ostream& out;
+    string buffer;
+    size_t chunkSize;
+
+public:
+    explicit OutputBuffer(ostream& out, size_t chunkSize = 64 * 1024) : out(out), chunkSize(chunkSize) {
+        buffer.reserve(chunkSize + 256);
+    }
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    ~OutputBuffer() {
+        flush();
+    }
+
+    OutputBuffer& text(string_view value) {
+        buffer.append(value.data(), value.size());
+        return *this;
+    }
+
+    OutputBuffer& number(long long value) {
+        char digits[24];
+        auto result = to_chars(digits, digits + sizeof(digits), value);
+        buffer.append(digits, static_cast<size_t>(result.ptr - digits));
+        return *this;
+    }
+
+    // Tekstas, papildytas tarpais iki width simboliu (kaip setw)
+    OutputBuffer& padded(string_view value, size_t width, bool alignRight = false) {
+        size_t fill = value.size() < width ? width - value.size() : 0;
+        if (alignRight) buffer.append(fill, ' ');
+        buffer.append(value.data(), value.size());
+        if (!alignRight) buffer.append(fill, ' ');
+        return *this;
+    }
+
+    OutputBuffer& paddedNumber(long long value, size_t width, bool alignRight = false) {
+        char digits[24];
+        auto result = to_chars(digits, digits + sizeof(digits), value);
+        return padded(string_view(digits, static_cast<size_t>(result.ptr - digits)), width, alignRight);
+    }
+
+    OutputBuffer& repeat(char c, size_t count) {
+        buffer.append(count, c);
+        return *this;
+    }
+
+    // Uzbaigia eilute; pilnas buferis israsomas i srauta
+    void endLine() {
+        buffer += '\n';
+        if (buffer.size() >= chunkSize) flush();
+    }
+
+    void flush() {
+        if (buffer.empty()) return;
+        out.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+        buffer.clear();
+    }
+};
+
+// Funkcija linijai i buferi irasyti
+void renderLine(OutputBuffer& out, int length = 50) {
+    out.repeat('-', static_cast<size_t>(length)).endLine();
+}
+
+// Funkcija pavadinimui su borteliais i buferi irasyti
+void renderTitle(OutputBuffer& out, const string& title) {
+    renderLine(out);
+    out.text("| ").padded(title, 46).text("|").endLine();
+    renderLine(out);
+}
+
 // Funkcija linijai atspausdinti
 void printLine(int length = 50) {
-    cout << setfill('-') << setw(length) << "-" << setfill(' ') << endl;
+    OutputBuffer out(cout);
+    renderLine(out, length);
 }
 
 // Funkcija pavadinimui su borteliais atspausdinti
 void printTitle(const string& title) {
-    printLine();
-    cout << "| " << left << setw(46) << title << "|" << endl;
-    printLine();
+    OutputBuffer out(cout);
+    renderTitle(out, title);
 }
 
-// Bazine klase LibraryItem - abstrakti klase bibliotekos knygoms
-class LibraryItem {
-protected:
-    static int nextID;      // Kitos knygos unikalus ID
-    int id;                 // Knygos unikalus ID
-    string title;           // Pavadinimas
-    string author;          // Autorius
-    int year;               // Leidimo metai
-    string category;        // Zanras
-    bool isAvailable;       // Prieinamumo busena
+// Funkcija raktui normalizuoti: pasalinami krastiniai tarpai, raides mazinamos
+string normalizeKey(string_view text) {
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == string_view::npos) return "";
+    size_t end = text.find_last_not_of(" \t\r\n");
+    string key(text.substr(begin, end - begin + 1));
+    for (auto& c : key) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    return key;
+}
+
+// Ar lauka galima irasyti i duomenu faila: '|' ir eilutes pabaiga sugadintu irasa
+bool isStorableField(string_view field) {
+    return field.find_first_of("|\r\n") == string_view::npos;
+}
+
+// Funkcija laukams, atskirtiems '|', prirasyti prie failo ar zurnalo eilutes
+void appendFields(string& line, initializer_list<string_view> fields) {
+    bool first = true;
+    for (string_view field : fields) {
+        if (!first) line += '|';
+        line.append(field.data(), field.size());
+        first = false;
+    }
+}
+
+// Failas, atvaizduotas i atminti tik skaitymui (mmap)
+class MappedFile {
+private:
+    const char* data = nullptr;
+    size_t length = 0;
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        close();
+    }
+
+    // Grazina false, jei failo nera arba jo nepavyko atvaizduoti. sequential - failas bus
+    // skaitomas nuo pradzios iki galo (branduolys skaito i prieki); kitaip - pasirinktinai.
+    bool open(const string& path, bool sequential = true) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            return false;
+        }
+        length = static_cast<size_t>(info.st_size);
+        if (length > 0) {
+            void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd);
+                length = 0;
+                return false;
+            }
+            if (sequential) ::madvise(mapped, length, MADV_SEQUENTIAL);
+            data = static_cast<const char*>(mapped);
+        }
+        ::close(fd);
+        return true;
+    }
+
+    void close() {
+        if (data) ::munmap(const_cast<char*>(data), length);
+        data = nullptr;
+        length = 0;
+    }
+
+    string_view view() const { return string_view(data, length); }
+};
+
+// Randa pirmaji simboli a arba b intervale [p, end); jei nera - grazina end.
+// Su SSE2 tikrinama po 16 baitu vienu metu.
+inline const char* findEither(const char* p, const char* end, char a, char b) {
+#ifdef __SSE2__
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, va), _mm_cmpeq_epi8(chunk, vb)));
+        if (mask) return p + __builtin_ctz(static_cast<unsigned>(mask));
+        p += 16;
+    }
+#endif
+    while (p < end && *p != a && *p != b) ++p;
+    return p;
+}
+
+// Vienas failo irasas - laukai rodo tiesiai i atvaizduota faila
+struct Record {
+    static constexpr size_t MaxFields = 9;
+    string_view fields[MaxFields];
+    size_t count = 0;         // Tikras lauku skaicius (gali virsyti MaxFields)
+    size_t lineNumber = 0;
+    bool terminated = false;  // Ar eilute baigiasi '\n'
+
+    bool isBlank() const { return count == 1 && fields[0].empty(); }
+};
+
+// Skaido '|' (ar kito skirtuko) atskirtus irasus po viena eilute, nekopijuodamas duomenu
+class RecordScanner {
+private:
+    const char* p;
+    const char* end;
+    char delimiter;
+    size_t line = 0;
 
 public:
-    LibraryItem(string title, string author, int year, string category)
-            : title(title), author(author), year(year), category(category), isAvailable(true) {
-        id = nextID++; // Priskiriame unikalų ID ir didiname jį
+    RecordScanner(string_view data, char delimiter)
+            : p(data.data()), end(data.data() + data.size()), delimiter(delimiter) {}
+
+    bool next(Record& record) {
+        if (p >= end) return false;
+        record.count = 0;
+        record.lineNumber = ++line;
+        const char* fieldStart = p;
+        while (true) {
+            const char* hit = findEither(p, end, delimiter, '\n');
+            string_view field(fieldStart, static_cast<size_t>(hit - fieldStart));
+            bool lineEnd = hit == end || *hit == '\n';
+            if (lineEnd && !field.empty() && field.back() == '\r') field.remove_suffix(1);
+            if (record.count < Record::MaxFields) record.fields[record.count] = field;
+            ++record.count;
+            if (lineEnd) {
+                record.terminated = hit != end;
+                p = hit == end ? end : hit + 1;
+                return true;
+            }
+            p = hit + 1;
+            fieldStart = p;
+        }
+    }
+};
+
+// Funkcija CSV eilutei (be '\n') isskaidyti i laukus. Laukai kabutese perrasomi vietoje
+// ("" -> "), todel duomenys nekopijuojami. Grazina false, jei kabutes netinkamos.
+bool splitCsvLine(char* p, char* end, Record& record) {
+    if (end > p && end[-1] == '\r') --end;
+    record.count = 0;
+    while (true) {
+        char* fieldStart = p;
+        char* fieldEnd;
+        if (p < end && *p == '"') {
+            fieldEnd = p;
+            ++p;
+            while (true) {
+                if (p == end) return false; // Neuzdarytos kabutes
+                if (*p == '"' && (p + 1 == end || p[1] != '"')) break;
+                if (*p == '"') ++p;
+                *fieldEnd++ = *p++;
+            }
+            ++p;
+            if (p < end && *p != ',') return false; // Tekstas po uzdaranciu kabuciu
+        } else {
+            while (p < end && *p != ',') ++p;
+            fieldEnd = p;
+        }
+        if (record.count < Record::MaxFields) {
+            record.fields[record.count] = string_view(fieldStart, static_cast<size_t>(fieldEnd - fieldStart));
+        }
+        ++record.count;
+        if (p == end) return true;
+        ++p;
+    }
+}
+
+// Funkcija laukui CSV formatu prirasyti: laukas su kableliu ar kabutemis imamas i kabutes
+void appendCsvField(string& line, string_view field) {
+    if (field.find_first_of(",\"") == string_view::npos) {
+        line.append(field.data(), field.size());
+        return;
+    }
+    line += '"';
+    for (char c : field) {
+        if (c == '"') line += '"';
+        line += c;
     }
+    line += '"';
+}
+
+// Ar failas CSV (pagal pletini), ar '|' atskirtas kaip books.txt
+bool isCsvPath(const string& path) {
+    return path.size() >= 4 && normalizeKey(path.substr(path.size() - 4)) == ".csv";
+}
+
+// Funkcija sveikajam skaiciui (int, int64_t ...) is lauko nuskaityti; grazina false, jei laukas netinkamas
+template <typename Int>
+bool parseInt(string_view field, Int& value) {
+    const char* first = field.data();
+    const char* last = field.data() + field.size();
+    while (first < last && *first == ' ') ++first;
+    while (last > first && last[-1] == ' ') --last;
+    auto result = from_chars(first, last, value);
+    return first != last && result.ec == errc() && result.ptr == last;
+}
+
+// Funkcija metams ("1850") ar ju intervalui ("1850-1900") nuskaityti
+bool parseYearRange(string_view text, int& fromYear, int& toYear) {
+    size_t dash = text.find('-', 1); // Pirmas '-' gali buti neigiamu metu zenklas
+    if (dash == string_view::npos) {
+        if (!parseInt(text, fromYear)) return false;
+        toYear = fromYear;
+        return true;
+    }
+    return parseInt(text.substr(0, dash), fromYear) && parseInt(text.substr(dash + 1), toYear) && fromYear <= toYear;
+}
 
-    virtual void displayInfo() const = 0; // Abstrakti funkcija informacijos atvaizdavimui
+// Funkcija laiko momentui paversti vietinio laiko tekstu "YYYY-MM-DD HH:MM:SS" (failams ir ekranui).
+// Isimenama paskutine valanda, todel daugybei artimu datu localtime_r kvieciamas retai.
+string formatTime(time_t time) {
+    thread_local bool cached = false;
+    thread_local time_t hourStart = 0;
+    thread_local char prefix[16];  // "YYYY-MM-DD HH:"
+    if (!cached || time < hourStart || time >= hourStart + 3600) {
+        struct tm parts;
+        if (!localtime_r(&time, &parts)) return "?";
+        strftime(prefix, sizeof(prefix), "%Y-%m-%d %H:", &parts);
+        hourStart = time - parts.tm_min * 60 - parts.tm_sec;
+        cached = true;
+    }
+    int offset = static_cast<int>(time - hourStart);
+    string text(prefix);
+    text += static_cast<char>('0' + offset / 600);
+    text += static_cast<char>('0' + offset / 60 % 10);
+    text += ':';
+    text += static_cast<char>('0' + offset % 60 / 10);
+    text += static_cast<char>('0' + offset % 10);
+    return text;
+}
 
-    virtual bool checkAvailability() const {
-        return isAvailable;
+// Funkcija tekstui "YYYY-MM-DD HH:MM:SS" (vietinis laikas) paversti laiko momentu.
+// Valandu pradzios isimenamos mazoje lenteleje, todel mktime kvieciamas tik naujai valandai.
+bool parseTime(string_view text, time_t& value) {
+    if (text.size() != 19 || text[4] != '-' || text[7] != '-' || text[10] != ' ' || text[13] != ':' || text[16] != ':') {
+        return false;
+    }
+    auto digits = [&](size_t pos, size_t count, int& out) {
+        return parseInt(text.substr(pos, count), out) && text[pos] != ' ' && text[pos + count - 1] != ' ';
+    };
+    int year, month, day, hour, minute, second;
+    if (!digits(0, 4, year) || !digits(5, 2, month) || !digits(8, 2, day) ||
+        !digits(11, 2, hour) || !digits(14, 2, minute) || !digits(17, 2, second) ||
+        hour > 23 || minute > 59 || second > 60) {
+        return false;
+    }
+    const size_t CacheSize = 1024;
+    thread_local long long cachedKeys[CacheSize];
+    thread_local time_t cachedHours[CacheSize];
+    thread_local bool cacheReady = false;
+    if (!cacheReady) {
+        fill(cachedKeys, cachedKeys + CacheSize, -1);
+        cacheReady = true;
     }
+    long long key = ((static_cast<long long>(year) * 100 + month) * 100 + day) * 100 + hour;
+    size_t slot = static_cast<size_t>(static_cast<uint64_t>(key) * 2654435761u % CacheSize);
+    long long& cachedKey = cachedKeys[slot];
+    time_t& cachedHour = cachedHours[slot];
+    if (key != cachedKey) {
+        struct tm parts{};
+        parts.tm_year = year - 1900;
+        parts.tm_mon = month - 1;
+        parts.tm_mday = day;
+        parts.tm_hour = hour;
+        parts.tm_isdst = -1;
+        time_t hourTime = mktime(&parts);
+        if (hourTime == -1 || parts.tm_mday != day || parts.tm_mon != month - 1) return false; // Pvz., 02-31
+        cachedKey = key;
+        cachedHour = hourTime;
+    }
+    value = cachedHour + minute * 60 + second;
+    return true;
+}
+
+// Funkcija netinkamai failo eilutei pranesti
+void reportBadLine(const string& file, size_t lineNumber, const string& reason) {
+    // Visa eilute rasoma vienu kartu, kad lygiagreciai kraunamu failu pranesimai nesusimaisytu
+    cerr << (file + ":" + to_string(lineNumber) + ": " + reason + " - eilute praleista.\n");
+}
 
-    virtual void borrowItem() {
-        if (!isAvailable) throw runtime_error("Knyga jau rezervuota.");
-        isAvailable = false;
+// Funkcija failo turiniui padalinti i ne daugiau kaip parts daliu; kiekviena dalis
+// (isskyrus paskutine) baigiasi '\n', todel irasai tarp daliu nesuskyla
+vector<string_view> splitLines(string_view data, size_t parts) {
+    vector<string_view> chunks;
+    size_t begin = 0;
+    for (size_t i = 1; i < parts && begin < data.size(); ++i) {
+        size_t target = max(begin, data.size() * i / parts);
+        size_t newline = data.find('\n', target);
+        if (newline == string_view::npos) break;
+        chunks.push_back(data.substr(begin, newline + 1 - begin));
+        begin = newline + 1;
     }
+    if (begin < data.size() || chunks.empty()) chunks.push_back(data.substr(begin));
+    return chunks;
+}
+
+// Failo dalies dydis: pakankamai didele, kad gijos apsimoketu, ir pakankamai maza, kad
+// vienu metu atmintyje butu tik keliu daliu tarpiniai rezultatai
+constexpr size_t ParseChunkBytes = 1024 * 1024;
+
+// Kiek daliu nagrineti vienu metu: po viena kiekvienam branduoliui
+size_t parallelChunks() {
+    return max<size_t>(1, thread::hardware_concurrency());
+}
 
-    virtual void returnItem() {
-        isAvailable = true;
+// Funkcija f(i) kiekvienam i < count ivykdyti lygiagreciai (i = 0 - einamojoje gijoje)
+template <typename Func>
+void runParallel(size_t count, Func f) {
+    vector<thread> workers;
+    for (size_t i = 1; i < count; ++i) workers.emplace_back(f, i);
+    if (count > 0) f(0);
+    for (auto& worker : workers) worker.join();
+}
+
+// Funkcija failui isnagrineti dalimis: parse(rec, entry) uzpildo entry arba grazina klaidos
+// aprasa. consume(entry) ir reportBadLine kvieciami vienoje gijoje failo tvarka, todel
+// rezultatas nepriklauso nuo daliu skaiciaus. firstLine - kiek eiluciu failo yra pries data
+// (nagrinejant srauta blokais); workers - kiek daliu nagrineti vienu metu. Grazinamas eiluciu
+// skaicius po data.
+template <typename Entry, typename Parse, typename Consume>
+size_t parseInParallel(string_view data, char delimiter, const string& fileName, Parse parse, Consume consume,
+                       size_t firstLine = 0, size_t workers = parallelChunks()) {
+    struct Parsed {
+        Entry entry;
+        size_t line;
+        string error;
+    };
+    struct Chunk {
+        vector<Parsed> entries;
+        size_t lines = 0;
+    };
+    vector<string_view> parts = splitLines(data, max<size_t>(1, data.size() / ParseChunkBytes));
+    // Dalys nagrinejamos grupemis po workers, o kiekvienos grupes irasai sunaudojami
+    // pries imant kita - tarpiniu irasu niekada nebuna daugiau nei vienai grupei
+    workers = max<size_t>(1, workers);
+    for (size_t first = 0; first < parts.size(); first += workers) {
+        vector<Chunk> chunks(min(workers, parts.size() - first));
+        runParallel(chunks.size(), [&](size_t i) {
+            RecordScanner scanner(parts[first + i], delimiter);
+            Record rec;
+            while (scanner.next(rec)) {
+                Parsed parsed{Entry(), rec.lineNumber, string()};
+                if (!parse(rec, parsed.entry, parsed.error)) continue; // Tuscia eilute
+                chunks[i].entries.push_back(std::move(parsed));
+            }
+            chunks[i].lines = rec.lineNumber;
+        });
+        for (auto& chunk : chunks) {
+            for (auto& parsed : chunk.entries) {
+                if (parsed.error.empty()) parsed.error = consume(parsed.entry);
+                if (!parsed.error.empty()) reportBadLine(fileName, firstLine + parsed.line, parsed.error);
+            }
+            firstLine += chunk.lines;
+        }
     }
+    return firstLine;
+}
+
+// Dvejetainis katalogo vaizdas (library.snap). Failas atvaizduojamas su mmap ir naudojamas
+// tiesiogiai: stulpeliai, zodynai ir surusiuoti indeksu masyvai skaitomi is atvaizduotos
+// srities, todel kraunant jie nekuriami ir nerusiuojami. Sekcijos - fiksuoto dydzio irasu
+// masyvai, sulygiuoti 8 baitais; eilutes laikomos bendrame bloke, i kuri rodo poslinkiai.
+// Baitu tvarka - kompiuterio. Vartotojai ir rezervacijos faile nelaikomi (tekstiniai failai).
+namespace snapshot {
+
+const char Magic[8] = {'B', 'I', 'B', 'S', 'N', 'A', 'P', '\0'};
+// 2 - rezervaciju laikai epochos sekundemis, 3 - leidiniu rusys, 4 - tik katalogas su indeksais
+const uint32_t Version = 4;
 
-    int getID() const { return id; } // Naujas metodas ID gavimui
-    string getTitle() const { return title; }
-    string getAuthor() const { return author; }
-    string getCategory() const { return category; }
-    virtual ~LibraryItem() {}
+// Sekcijos failo tvarka. "Eilutei" - po irasa kiekvienai katalogo eilutei; zodynas - eilutes
+// (ID -> String) ir ID, surusiuoti pagal eilute; apverstinis indeksas - surusiuoti raktai,
+// ju sarasu pradzios (raktu + 1) ir sujungti eiluciu sarasai.
+enum Section : uint32_t {
+    ItemIDs,                                // int32_t eilutei, didejantys
+    Years,                                  // int32_t eilutei
+    CategoryCodes, AuthorCodes,             // uint32_t eilutei
+    Titles,                                 // String eilutei
+    Kinds,                                  // Kind eilutei
+    NextRowOfTitle,                         // uint32_t eilutei
+    Authors, AuthorOrder,                   // Zodynai
+    Categories, CategoryOrder,
+    TitleKeys, TitleKeyOrder,
+    AuthorKeys, AuthorKeyOrder,
+    CategoryKeys, CategoryKeyOrder,
+    FirstRowOfTitle, LastRowOfTitle,        // uint32_t pavadinimo raktui
+    PrefixEntries,                          // PrefixIndex irasai
+    YearEntries, CategoryYearEntries,       // YearIndex irasai
+    CategoryTerms, CategoryOffsets, CategoryRows,  // Apverstiniai indeksai
+    WordTerms, WordOffsets, WordRows,
+    Strings,                                // Bendras eiluciu blokas
+    SectionCount
 };
 
-// Inicializuojame static ID
-int LibraryItem::nextID = 1;
+// Sekcijos iraso dydis baitais
+const uint32_t ElementSizes[SectionCount] = {
+    4, 4, 4, 4, 8, 8, 4,
+    8, 4, 8, 4, 8, 4, 8, 4, 8, 4,
+    4, 4,
+    12, 12, 12,
+    8, 8, 4, 8, 8, 4,
+    1};
+
+struct Range {
+    uint64_t offset;
+    uint64_t count;   // Irasu skaicius
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t checksum;           // Visam failui po antrastes
+    uint64_t rows;               // Katalogo eiluciu skaicius
+    Range sections[SectionCount];
+};
+
+// Eilute bendrame bloke
+struct String {
+    uint32_t offset;
+    uint32_t length;
+};
+
+// Leidinio rusis (ItemKind) ir zurnalo numeris arba DVD trukme
+struct Kind {
+    uint32_t kind;
+    int32_t detail;
+};
+
+// FNV-1a atmaina, apdorojanti po 8 baitus: failas tikrinamas visas, todel skaiciuojama greitai
+uint64_t checksum(string_view data) {
+    uint64_t hash = 14695981039346656037ull;
+    size_t words = data.size() / 8;
+    for (size_t i = 0; i < words; ++i) {
+        uint64_t word;
+        memcpy(&word, data.data() + i * 8, 8);
+        hash = (hash ^ word) * 1099511628211ull;
+        hash ^= hash >> 32;
+    }
+    for (size_t i = words * 8; i < data.size(); ++i) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// Surenka failo turini atmintyje: sekcijos prirasomos viena po kitos, eiluciu blokas - paskutinis
+class Writer {
+private:
+    Header header{};
+    string file;        // Antrastes vieta ir jau prirasytos sekcijos
+    string strings;
+    bool overflow = false;  // Eiluciu blokas netelpa i 32 bitu poslinkius
 
-// Knygos klase, paveldi LibraryItem
-class Book : public LibraryItem {
 public:
-    Book(string title, string author, int year, string category)
-            : LibraryItem(title, author, year, category) {}
+    Writer() : file(sizeof(Header), '\0') {}
+
+    String add(string_view text) {
+        if (text.size() > UINT32_MAX - strings.size()) {
+            overflow = true;
+            return String{0, 0};
+        }
+        String ref{static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(text.size())};
+        strings.append(text.data(), text.size());
+        return ref;
+    }
 
-    void displayInfo() const override {
-        cout << left << setw(25) << title
-             << "| " << setw(20) << author
-             << "| " << right << setw(4) << year << " "
-             << "| " << left << setw(10) << category
-             << "| " << setw(7) << (isAvailable ? "Laisva" : "Uzimta") << " |" << endl;
+    template <typename T>
+    void put(Section section, const T* items, size_t count) {
+        static_assert(is_trivially_copyable<T>::value, "sekcijos irasai kopijuojami baitais");
+        file.resize((file.size() + 7) & ~size_t(7), '\0');
+        header.sections[section] = {file.size(), count};
+        if (count > 0) file.append(reinterpret_cast<const char*>(items), count * sizeof(T));
     }
 
+    template <typename T>
+    void put(Section section, const vector<T>& items) { put(section, items.data(), items.size()); }
+
+    // Tuscia eilute, jei eiluciu blokas virsijo 4 GiB (poslinkiai butu apsisuke)
+    string build(uint64_t rows) {
+        if (overflow) return string();
+        put(Strings, strings.data(), strings.size());
+        memcpy(header.magic, Magic, sizeof(Magic));
+        header.version = Version;
+        header.headerSize = sizeof(Header);
+        header.rows = rows;
+        header.checksum = checksum(string_view(file).substr(sizeof(Header)));
+        memcpy(&file[0], &header, sizeof(Header));
+        return std::move(file);
+    }
 };
 
-// Vartotojo klase
-class User {
+// Patikrintas atvaizduotas failas; rodykles rodo tiesiai i mmap sriti
+struct View {
+    const Header* header = nullptr;
+    const char* base = nullptr;
+    string_view strings;
+
+    template <typename T>
+    const T* items(Section section) const {
+        return reinterpret_cast<const T*>(base + header->sections[section].offset);
+    }
+    size_t count(Section section) const { return header->sections[section].count; }
+    string_view get(String ref) const { return strings.substr(ref.offset, ref.length); }
+};
+
+// Patikrina antraste, versija, sekciju ribas ir dydzius bei kontroline suma; klaidos atveju
+// grazina priezasti. Atskiri irasai netikrinami: failas naudojamas tiesiogiai, ji raso tik si
+// programa, o nuo sugadinimo saugo kontroline suma.
+const char* open(string_view data, View& view) {
+    if (data.size() < sizeof(Header)) return "per trumpas failas";
+    const Header* header = reinterpret_cast<const Header*>(data.data());
+    if (memcmp(header->magic, Magic, sizeof(Magic)) != 0) return "netinkamas failo zenklas";
+    if (header->version != Version || header->headerSize != sizeof(Header)) return "nepalaikoma versija";
+    for (uint32_t s = 0; s < SectionCount; ++s) {
+        const Range& range = header->sections[s];
+        if (range.offset % 8 != 0 || range.offset < sizeof(Header) || range.offset > data.size() ||
+            range.count > (data.size() - range.offset) / ElementSizes[s]) {
+            return "sekcija uz failo ribu";
+        }
+    }
+    auto count = [&](Section section) { return header->sections[section].count; };
+    for (Section section : {ItemIDs, Years, CategoryCodes, AuthorCodes, Titles, Kinds, NextRowOfTitle}) {
+        if (count(section) != header->rows) return "netinkamas stulpelio ilgis";
+    }
+    for (Section section : {Authors, Categories, TitleKeys, AuthorKeys, CategoryKeys}) {
+        if (count(Section(section + 1)) != count(section)) return "netinkamas zodyno ilgis";
+    }
+    if (count(FirstRowOfTitle) != count(TitleKeys) || count(LastRowOfTitle) != count(TitleKeys) ||
+        count(CategoryOffsets) != count(CategoryTerms) + 1 || count(WordOffsets) != count(WordTerms) + 1) {
+        return "netinkamas indekso ilgis";
+    }
+    if (checksum(data.substr(sizeof(Header))) != header->checksum) return "nesutampa kontroline suma";
+
+    view.header = header;
+    view.base = data.data();
+    view.strings = string_view(view.items<char>(Strings), count(Strings));
+    return nullptr;
+}
+
+} // namespace snapshot
+
+// Stulpelis: savas vector arba masyvas atvaizduotame library.snap, skaitomas tiesiai is failo.
+// Pirmas pakeitimas atvaizduota masyva nukopijuoja (kopijuojama tik rasant).
+template <typename T>
+class Column {
 private:
-    string name;  // Vartotojo vardas
-    string password; // Vartotojo slaptažodis
+    vector<T> owned;
+    const T* mapped = nullptr;  // nullptr - naudojamas owned
+    size_t mappedCount = 0;
 
 public:
-    User(string name, string password) : name(name), password(password) {}
+    void attach(const T* items, size_t count) {
+        owned = vector<T>();
+        mapped = items;
+        mappedCount = count;
+    }
 
-    void displayUserInfo() const {
-        cout << "| Vardas: " << setw(15) << name << " |" << endl;
+    void attach(const snapshot::View& file, snapshot::Section section) {
+        attach(file.items<T>(section), file.count(section));
+    }
+
+    void save(snapshot::Writer& out, snapshot::Section section) const { out.put(section, data(), size()); }
+
+    const T* data() const { return mapped ? mapped : owned.data(); }
+    size_t size() const { return mapped ? mappedCount : owned.size(); }
+    bool empty() const { return size() == 0; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + size(); }
+    const T& operator[](size_t i) const { return data()[i]; }
+    const T& back() const { return data()[size() - 1]; }
+
+    vector<T>& edit() {
+        if (mapped) {
+            owned.assign(mapped, mapped + mappedCount);
+            mapped = nullptr;
+        }
+        return owned;
     }
 
-    string getName() const { return name; }
-    string getPassword() const { return password; }
+    void push_back(const T& value) { edit().push_back(value); }
+    void set(size_t i, const T& value) { edit()[i] = value; }
 };
 
-// Rezervacijos klase
-class Reservation {
+// Eiluciu blokas: eilutes kopijuojamos i didelius gabalus, kurie niekada neperkeliami,
+// todel grazinti string_view galioja visa bloko gyvavimo laika
+class StringArena {
 private:
-    User* user;
-    LibraryItem* item;
-    string reservationDate; // Rezervacijos data
-    string returnDate;      // Atsiimimo data
+    static constexpr size_t ChunkSize = 256 * 1024;
+    vector<unique_ptr<char[]>> chunks;
+    char* current = nullptr;  // Laisvos vietos pradzia paskutiniame gabale
+    size_t left = 0;
+    size_t bytes = 0;
 
 public:
-    // Pagrindinis konstruktorius (automatinė data)
-    Reservation(User* user, LibraryItem* item)
-            : user(user), item(item) {
-        auto now = chrono::system_clock::now();
-        time_t now_time = chrono::system_clock::to_time_t(now);
+    string_view add(string_view text) {
+        if (text.size() > left) {
+            size_t size = max(ChunkSize, text.size());
+            chunks.emplace_back(new char[size]);
+            current = chunks.back().get();
+            left = size;
+        }
+        memcpy(current, text.data(), text.size());
+        string_view stored(current, text.size());
+        current += text.size();
+        left -= text.size();
+        bytes += text.size();
+        return stored;
+    }
 
-        // Rezervacijos data
-        char buffer[20];
-        strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", localtime(&now_time));
-        reservationDate = string(buffer);
+    size_t size() const { return bytes; }
+};
+
+// Eiluciu stulpelis (numeris -> eilute). Pradzia gali buti atvaizduota is library.snap ir
+// skaitoma tiesiai is failo; naujos eilutes kopijuojamos i bloka ir pridedamos po jos.
+// Nei eilutes, nei ju rodykles neperkeliamos (segmentai didinami dvigubai, o ju lentele
+// fiksuoto dydzio), todel skaitytojas, gaves numeri is paskelbtos indeksu versijos, eilute
+// skaito be uzraktu, nors rasytojas tuo metu prideda naujas.
+class TextColumn {
+private:
+    static constexpr size_t FirstSegment = 1024;
+    const snapshot::String* mappedRefs = nullptr;
+    string_view mappedText;
+    size_t mappedCount = 0;
+    StringArena arena;
+    array<unique_ptr<string_view[]>, 48> segments;  // Segmente k - FirstSegment << k eiluciu
+    size_t addedCount = 0;                          // Eilutes po atvaizduotos dalies
 
-        // Atsiemimo data (pridedame 10 dienų)
-        auto return_time = now + chrono::hours(24 * 10);
-        time_t return_time_t = chrono::system_clock::to_time_t(return_time);
-        strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", localtime(&return_time_t));
-        returnDate = string(buffer);
+    // Segmentas ir vieta jame pridetos eilutes numeriui i
+    static pair<size_t, size_t> locate(size_t i) {
+        size_t segment = 63 - static_cast<size_t>(__builtin_clzll(i / FirstSegment + 1));
+        return {segment, i - FirstSegment * ((size_t(1) << segment) - 1)};
     }
 
-    // Konstruktorius su konkrečiomis datomis
-    Reservation(User* user, LibraryItem* item, const string& reservationDate, const string& returnDate)
-            : user(user), item(item), reservationDate(reservationDate), returnDate(returnDate) {}
+public:
+    TextColumn() = default;
+    // Kopija turi savo eiluciu bloka; atvaizduota dalis bendra
+    TextColumn(const TextColumn& other)
+            : mappedRefs(other.mappedRefs), mappedText(other.mappedText), mappedCount(other.mappedCount) {
+        for (size_t i = mappedCount; i < other.size(); ++i) add(other.get(i));
+    }
+    TextColumn& operator=(const TextColumn&) = delete;
 
-    void displayReservationInfo() const {
-        printTitle("Rezervacijos informacija");
-        cout << "Rezervacijos data: " << reservationDate << endl;
-        cout << "Atsiimti iki: " << returnDate << endl;
-        user->displayUserInfo();
-        printLine();
-        item->displayInfo();
-        printLine();
+    // Kvieciama tusciam stulpeliui
+    void attach(const snapshot::View& file, snapshot::Section section) {
+        mappedRefs = file.items<snapshot::String>(section);
+        mappedCount = file.count(section);
+        mappedText = file.strings;
     }
 
-    void cancelReservation() {
-        item->returnItem();
+    void save(snapshot::Writer& out, snapshot::Section section) const {
+        vector<snapshot::String> refs;
+        refs.reserve(size());
+        for (size_t i = 0; i < size(); ++i) refs.push_back(out.add(get(i)));
+        out.put(section, refs);
     }
 
-    User* getUser() const { return user; }
-    LibraryItem* getItem() const { return item; }
+    string_view add(string_view text) {
+        auto [segment, offset] = locate(addedCount);
+        if (!segments[segment]) segments[segment].reset(new string_view[FirstSegment << segment]);
+        string_view stored = arena.add(text);
+        segments[segment][offset] = stored;
+        ++addedCount;
+        return stored;
+    }
 
-    string getReservationDate() const {
-        return reservationDate;
+    string_view get(size_t i) const {
+        if (i < mappedCount) return mappedText.substr(mappedRefs[i].offset, mappedRefs[i].length);
+        auto [segment, offset] = locate(i - mappedCount);
+        return segments[segment][offset];
     }
 
-    string getReturnDate() const {
-        return returnDate;
+    size_t size() const { return mappedCount + addedCount; }
+
+    // Eiluciu baitai (atvaizduotos dalies - sumuojami, todel tik statistikai)
+    size_t bytes() const {
+        size_t total = arena.size();
+        for (size_t i = 0; i < mappedCount; ++i) total += mappedRefs[i].length;
+        return total;
     }
 };
 
-// Bibliotekos klase
-class Library {
+// Eiluciu zodynas: kiekviena skirtinga eilute saugoma viena karta ir gauna sveikaji ID,
+// todel vienodu eiluciu palyginimas tampa skaiciu palyginimu. Is library.snap atvaizduotos
+// eilutes randamos dvejetaine paieska pagal faile surusiuotus ID, o naujos - maisos lenteleje.
+class StringDictionary {
 private:
-    vector<LibraryItem*> items;
-    vector<User*> users;
-    vector<Reservation*> reservations;
-    User* loggedInUser = nullptr;
+    TextColumn strings;                         // ID -> eilute
+    const uint32_t* mappedOrder = nullptr;      // Atvaizduotu eiluciu ID, surusiuoti pagal eilute
+    size_t mappedCount = 0;
+    unordered_map<string_view, uint32_t> ids;   // Naujos eilutes; raktai rodo i strings
+
+    uint32_t findMapped(string_view text) const {
+        const uint32_t* end = mappedOrder + mappedCount;
+        const uint32_t* it = lower_bound(mappedOrder, end, text, [&](uint32_t id, string_view value) {
+            return strings.get(id) < value;
+        });
+        return it != end && strings.get(*it) == text ? *it : NotFound;
+    }
 
 public:
-    Library() {
-        loadItemsFromFile();
+    static constexpr uint32_t NotFound = UINT32_MAX;
+
+    StringDictionary() = default;
+    // Kopija turi savo eiluciu bloka; ID islieka tie patys
+    StringDictionary(const StringDictionary& other)
+            : strings(other.strings), mappedOrder(other.mappedOrder), mappedCount(other.mappedCount) {
+        for (size_t id = mappedCount; id < strings.size(); ++id) ids.emplace(strings.get(id), static_cast<uint32_t>(id));
     }
+    StringDictionary& operator=(const StringDictionary&) = delete;
 
-    void loadItemsFromFile() {
-        ifstream inFile("books.txt");
-        if (!inFile.is_open()) {
-            cout << "Failas books.txt nerastas. Sukuriamas naujas failas." << endl;
-            ofstream outFile("books.txt");
-            outFile.close();
-            return;
+    // Kvieciama tusciam zodynui
+    void attach(const snapshot::View& file, snapshot::Section text, snapshot::Section order) {
+        strings.attach(file, text);
+        mappedOrder = file.items<uint32_t>(order);
+        mappedCount = file.count(order);
+    }
+
+    // Atvaizduoti ID jau surusiuoti, todel rusiuojami tik nauji ir sujungiami su jais
+    void save(snapshot::Writer& out, snapshot::Section text, snapshot::Section order) const {
+        strings.save(out, text);
+        vector<uint32_t> sorted(mappedOrder, mappedOrder + mappedCount);
+        for (size_t id = mappedCount; id < strings.size(); ++id) sorted.push_back(static_cast<uint32_t>(id));
+        auto less = [&](uint32_t a, uint32_t b) { return strings.get(a) < strings.get(b); };
+        auto middle = sorted.begin() + static_cast<ptrdiff_t>(mappedCount);
+        sort(middle, sorted.end(), less);
+        inplace_merge(sorted.begin(), middle, sorted.end(), less);
+        out.put(order, sorted);
+    }
+
+    uint32_t intern(string_view text) {
+        uint32_t id = find(text);
+        if (id != NotFound) return id;
+        id = static_cast<uint32_t>(strings.size());
+        ids.emplace(strings.add(text), id);
+        return id;
+    }
+
+    uint32_t find(string_view text) const {
+        auto it = ids.find(text);
+        if (it != ids.end()) return it->second;
+        return mappedCount > 0 ? findMapped(text) : NotFound;
+    }
+
+    string_view get(uint32_t id) const { return strings.get(id); }
+    size_t size() const { return strings.size(); }
+    size_t bytes() const { return strings.bytes(); }
+};
+
+// RCU langelis: skaitytojai gauna nekintama T versija nieko nerakindami, o rasytojai
+// skelbia naujas versijas. Senos versijos atlaisvinamos epochomis (EBR): skaitytojas
+// pries paimdamas rodykle paskelbia einamaja epocha savo lizde, o pakeista versija
+// sunaikinama tik kai nebelieka skaitytoju, paskelbusiu ne velesne epocha.
+template <typename T>
+class Versioned {
+public:
+    static constexpr size_t MaxReaders = 128;  // Vienu metu skaitanciu giju
+
+private:
+    struct alignas(64) ReaderSlot {
+        atomic<uint64_t> epoch{0};  // 0 - lizdas laisvas
+    };
+    struct Retired {
+        uint64_t epoch;
+        unique_ptr<const T> value;
+    };
+    mutable ReaderSlot readers[MaxReaders];
+    atomic<uint64_t> globalEpoch{1};
+    atomic<T*> value{nullptr};
+    vector<Retired> retired;  // Pakeistos versijos, kurias dar gali skaityti
+
+    // Sunaikina versijas, pakeistas pries seniausia aktyvaus skaitytojo epocha
+    void reclaim() {
+        uint64_t oldest = UINT64_MAX;
+        for (const auto& reader : readers) {
+            uint64_t epoch = reader.epoch.load(memory_order_seq_cst);
+            if (epoch != 0) oldest = min(oldest, epoch);
         }
+        retired.erase(remove_if(retired.begin(), retired.end(),
+                                [&](const Retired& r) { return r.epoch < oldest; }),
+                      retired.end());
+    }
 
-        string title, author, category;
-        int year;
+public:
+    Versioned() = default;
+    Versioned(const Versioned&) = delete;
+    Versioned& operator=(const Versioned&) = delete;
+    ~Versioned() { delete value.load(); }
+
+    // Skaitytojo apsauga: kol ji gyva, gauta versija neatlaisvinama
+    class ReadGuard {
+    private:
+        ReaderSlot* slot;
+        const T* current;
 
-        while (getline(inFile, title, '|')) {
-            getline(inFile, author, '|');
-            inFile >> year;
-            inFile.ignore(1); // Skip the '|'
-            getline(inFile, category);
+    public:
+        ReadGuard(ReaderSlot* slot, const T* current) : slot(slot), current(current) {}
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        ~ReadGuard() { slot->epoch.store(0, memory_order_release); }
 
-            items.push_back(new Book(title, author, year, category));
+        const T* get() const { return current; }
+        const T* operator->() const { return current; }
+    };
+
+    // Paima dabartine versija (nullptr, jei dar nepaskelbta). Kiekviena gija pradeda nuo
+    // savo lizdo, todel skaitytojai nesidalija spartinancios atminties eilutemis.
+    ReadGuard read() const {
+        static atomic<size_t> nextHint{0};
+        thread_local size_t hint = nextHint.fetch_add(1, memory_order_relaxed);
+        uint64_t epoch = globalEpoch.load(memory_order_seq_cst);
+        for (size_t i = hint % MaxReaders, tried = 0;; i = (i + 1) % MaxReaders) {
+            uint64_t expected = 0;
+            if (readers[i].epoch.compare_exchange_strong(expected, epoch, memory_order_seq_cst)) {
+                hint = i;
+                return ReadGuard(&readers[i], value.load(memory_order_seq_cst));
+            }
+            if (++tried % MaxReaders == 0) this_thread::yield(); // Visi lizdai uzimti
         }
+    }
+
+    // Rasytojams (juos sutvarko kvieciantysis): dabartine versija be apsaugos
+    const T* current() const { return value.load(memory_order_relaxed); }
+    T* current() { return value.load(memory_order_relaxed); }
 
-        inFile.close();
+    // Paskelbia nauja versija; senoji atlaisvinama, kai ja baigs skaityti visi skaitytojai
+    void publish(unique_ptr<T> next) {
+        const T* previous = value.exchange(next.release(), memory_order_seq_cst);
+        if (previous) retired.push_back({globalEpoch.fetch_add(1, memory_order_seq_cst), unique_ptr<const T>(previous)});
+        if (retired.size() >= 8) reclaim(); // Lizdai perziurimi ne po kiekvieno pakeitimo
     }
 
-    void saveReservationsToFile() {
-        ofstream outFile("reservations.txt");
-        for (const auto& res : reservations) {
-            outFile << res->getUser()->getName() << "|"
-                    << res->getItem()->getTitle() << "|"
-                    << res->getItem()->getAuthor() << "|"
-                    << res->getItem()->getCategory() << "|"
-                    << res->getItem()->checkAvailability() << "|"
-                    << res->getReservationDate() << "|"
-                    << res->getReturnDate() << endl;
+    // Paskelbia nauja versija ir laukia, kol ankstesnes nebeskaitys ne vienas skaitytojas;
+    // tada ji grazinama rasytojui (pvz., kaip atsargine kopija)
+    unique_ptr<T> exchange(unique_ptr<T> next) {
+        T* previous = value.exchange(next.release(), memory_order_seq_cst);
+        uint64_t epoch = globalEpoch.fetch_add(1, memory_order_seq_cst);
+        for (const auto& reader : readers) {
+            for (uint64_t seen; (seen = reader.epoch.load(memory_order_seq_cst)) != 0 && seen <= epoch;) {
+                this_thread::yield();
+            }
         }
-        outFile.close();
+        return unique_ptr<T>(previous);
     }
 
-    void loadReservationsFromFile() {
-        ifstream inFile("reservations.txt");
-        if (!inFile.is_open()) {
-            cout << "Failas reservations.txt nerastas. Sukuriamas naujas failas." << endl;
-            ofstream outFile("reservations.txt");
-            outFile.close();
-            return;
+    size_t retiredCount() const { return retired.size(); }
+};
+
+// Funkcija f(row) kiekvienam nustatytam bitui iskviesti (eilutes nuo firstRow), praleidus
+// skip bitu ir ne daugiau nei limit; abu skaitikliai sumazinami. Praleidziami zodziai
+// skaiciuojami su popcount, todel puslapio pradzia randama nenagrinejant kiekvieno bito.
+template <typename Func>
+void forEachSetBit(const uint64_t* bits, size_t words, size_t firstRow, size_t& skip, size_t& limit, Func& f) {
+    for (size_t w = 0; w < words && limit > 0; ++w) {
+        uint64_t word = __atomic_load_n(&bits[w], __ATOMIC_ACQUIRE);
+        size_t count = static_cast<size_t>(__builtin_popcountll(word));
+        if (skip >= count) {
+            skip -= count;
+            continue;
+        }
+        while (word && limit > 0) {
+            if (skip > 0) {
+                --skip;
+            } else {
+                f(firstRow + w * 64 + static_cast<size_t>(__builtin_ctzll(word)));
+                --limit;
+            }
+            word &= word - 1;
         }
+    }
+}
 
-        string name, title, author, category, reservationDate, returnDate;
-        bool isAvailable;
+// Nekintama katalogo prieinamumo versija. Bitai laikomi blokais: nauja versija kopijuoja tik
+// pakeista bloka ir bloku rodykliu masyva, o kiti blokai bendri su ankstesnemis versijomis.
+// Pakeistas blokas atiduodamas ankstesnei versijai (replaced) ir sunaikinamas kartu su ja -
+// tada jo nebeskaito ir visos dar senesnes versijos.
+struct AvailabilityVersion {
+    static constexpr size_t BlockWords = 64;
+    static constexpr size_t BlockRows = BlockWords * 64;  // 4096 knygos bloke
 
-        while (getline(inFile, name, '|')) {
-            getline(inFile, title, '|');
-            getline(inFile, author, '|');
-            getline(inFile, category, '|');
-            inFile >> isAvailable;
-            inFile.ignore(1); // Skip the '|'
-            getline(inFile, reservationDate, '|');
-            getline(inFile, returnDate);
+    struct Block {
+        array<uint64_t, BlockWords> words;
+        uint32_t available;                 // Laisvu knygu skaicius bloke
+    };
 
-            User* user = nullptr;
-            for (auto& u : users) {
-                if (u->getName() == name) {
-                    user = u;
-                    break;
-                }
-            }
+    uint64_t number = 0;                    // Versijos numeris
+    size_t rows = 0;                        // Matomu eiluciu skaicius
+    size_t available = 0;                   // Laisvu knygu skaicius
+    vector<const Block*> blocks;
+    mutable vector<unique_ptr<const Block>> replaced;  // Keicia tik rasytojas, skelbdamas kita versija
+};
 
-            if (!user) {
-                user = new User(name, ""); // Jei vartotojas neegzistuoja, sukurti laikiną vartotoją
-                users.push_back(user);
-            }
+// Nuoseklus katalogo prieinamumo vaizdas skaitytojams: visi jo atsakymai atitinka ta pacia
+// versija, nors rezervacijos tuo metu keiciasi. Laikyti trumpai (pvz., vienam puslapiui),
+// nes kol vaizdas gyvas, ankstesnes versijos neatlaisvinamos.
+class CatalogSnapshot {
+private:
+    Versioned<AvailabilityVersion>::ReadGuard guard;
+    const AvailabilityVersion* version;
 
-            LibraryItem* item = nullptr;
-            for (auto& i : items) {
-                if (i->getTitle() == title) {
-                    item = i;
-                    if (!isAvailable) {
-                        item->borrowItem(); // Pažymėti knyga kaip rezervuotą
-                    }
-                    break;
-                }
+public:
+    explicit CatalogSnapshot(const Versioned<AvailabilityVersion>& versions)
+            : guard(versions.read()), version(guard.get()) {}
+
+    uint64_t number() const { return version ? version->number : 0; }
+    size_t rows() const { return version ? version->rows : 0; }
+    size_t countAvailable() const { return version ? version->available : 0; }
+
+    bool isAvailable(size_t row) const {
+        if (row >= rows()) return false;
+        const auto& block = *version->blocks[row / AvailabilityVersion::BlockRows];
+        size_t bit = row % AvailabilityVersion::BlockRows;
+        return (block.words[bit >> 6] >> (bit & 63)) & 1;
+    }
+
+    // Iskviecia f(row) laisvoms knygoms; praleidziami blokai skaiciuojami is ju laisvu knygu skaiciaus
+    template <typename Func>
+    void forEachAvailable(Func f, size_t skip = 0, size_t limit = SIZE_MAX) const {
+        if (!version) return;
+        for (size_t b = 0; b < version->blocks.size() && limit > 0; ++b) {
+            const auto& block = *version->blocks[b];
+            if (skip >= block.available) {
+                skip -= block.available;
+                continue;
             }
+            forEachSetBit(block.words.data(), AvailabilityVersion::BlockWords,
+                          b * AvailabilityVersion::BlockRows, skip, limit, f);
+        }
+    }
+};
+
+// Stulpeline katalogo saugykla: kiekvienas knygu laukas laikomas atskirame istisiniame masyve,
+// o prieinamumas - bitu rinkinyje (1 bitas knygai), kuri galima skaiciuoti su popcount.
+// Eilutes tik pridedamos (eilutes numeris - knygos vieta kataloge).
+// Autoriai ir zanrai laikomi zodynuose (eiluteje - tik kodas), pavadinimai - bendrame bloke.
+// Stulpelius ir zodynus galima naudoti tiesiai is library.snap (attach()).
+// Skaitytojams prieinamumas skelbiamas nekintamomis versijomis (snapshot()).
+class CatalogStore {
+private:
+    Column<int> ids;
+    Column<int> years;
+    Column<uint32_t> categoryCodes;
+    Column<uint32_t> authorCodes;
+    TextColumn titles;
+    StringDictionary authors;                            // Autoriaus kodas -> vardas
+    StringDictionary categories;                         // Zanro kodas -> pavadinimas
+    vector<uint64_t> availableBits;                      // 1 - knyga laisva
+    Versioned<AvailabilityVersion> versions;             // Skaitytoju prieinamumo vaizdas
+    vector<uint64_t> changedBlocks;                      // 1 - blokas pakeistas, bet dar nepaskelbtas
+    atomic<uint64_t> changeCount{0};                     // Pazymetu pakeitimu skaicius
+    uint64_t publishedCount = 0;                         // Kiek ju jau paskelbta (saugo publishMutex)
+    mutex publishMutex;                                  // Versijas skelbia po viena rasytoja
+
+    static uint64_t bitOf(size_t row) { return uint64_t(1) << (row & 63); }
+
+    static size_t blockCount(size_t rows) {
+        return (rows + AvailabilityVersion::BlockRows - 1) / AvailabilityVersion::BlockRows;
+    }
+
+    // Bloko b prieinamumo bitu kopija; eilutes nuo rows (dar nepaskelbtos) - nuliai
+    const AvailabilityVersion::Block* copyBlock(size_t b, size_t rows) const {
+        auto* block = new AvailabilityVersion::Block;
+        block->available = 0;
+        for (size_t i = 0; i < AvailabilityVersion::BlockWords; ++i) {
+            size_t w = b * AvailabilityVersion::BlockWords + i;
+            uint64_t word = w < availableBits.size() ? __atomic_load_n(&availableBits[w], __ATOMIC_ACQUIRE) : 0;
+            if (rows <= w * 64) word = 0;
+            else if (rows < (w + 1) * 64) word &= bitOf(rows) - 1;
+            block->words[i] = word;
+            block->available += static_cast<uint32_t>(__builtin_popcountll(word));
+        }
+        return block;
+    }
 
-            if (item) {
-                reservations.push_back(new Reservation(user, item, reservationDate, returnDate));
+    // Pazymi eilutes row bloka pakeistu ir grizta, kai pakeitimas jau paskelbtas. Pakeitimai
+    // skelbiami grupemis: kas pirmas gauna publishMutex, paskelbia visus iki tol pazymetus
+    // blokus viena versija, o kartu laukusieji randa savo pakeitima jau paskelbta ir nieko
+    // nekopijuoja. Naujos eilutes matomos tik po publish(), todel skaitytojai jas gauna ne
+    // anksciau nei paieskos indeksus. Kol pirma versija nepaskelbta (kraunant), nieko neskelbia.
+    void publishRow(size_t row) {
+        size_t changed = row / AvailabilityVersion::BlockRows;
+        __atomic_fetch_or(&changedBlocks[changed >> 6], bitOf(changed), __ATOMIC_ACQ_REL);
+        uint64_t ticket = changeCount.fetch_add(1, memory_order_acq_rel) + 1;
+        lock_guard<mutex> lock(publishMutex);
+        AvailabilityVersion* previous = versions.current();
+        if (!previous || publishedCount >= ticket) return;
+        publishedCount = changeCount.load(memory_order_acquire);
+        auto next = make_unique<AvailabilityVersion>();
+        next->number = previous->number + 1;
+        next->rows = previous->rows;
+        next->blocks = previous->blocks;
+        next->available = previous->available;
+        for (size_t w = 0; w < changedBlocks.size(); ++w) {
+            uint64_t word = __atomic_exchange_n(&changedBlocks[w], 0, __ATOMIC_ACQ_REL);
+            for (; word; word &= word - 1) {
+                size_t b = w * 64 + static_cast<size_t>(__builtin_ctzll(word));
+                if (b >= next->blocks.size()) continue; // Dar nepaskelbtos eilutes
+                const auto* old = next->blocks[b];
+                previous->replaced.emplace_back(old);
+                next->blocks[b] = copyBlock(b, next->rows);
+                next->available = next->available - old->available + next->blocks[b]->available;
             }
         }
+        versions.publish(std::move(next));
+    }
+
+public:
+    CatalogStore() = default;
+    CatalogStore(const CatalogStore&) = delete;
+    CatalogStore& operator=(const CatalogStore&) = delete;
 
-        inFile.close();
+    // Dabartines versijos blokai dar niekam neatiduoti
+    ~CatalogStore() {
+        if (const AvailabilityVersion* current = versions.current()) {
+            for (const auto* block : current->blocks) delete block;
+        }
     }
 
-    void loadUsersFromFile() {
-        ifstream inFile("users.txt");
-        if (!inFile.is_open()) {
-            cout << "Failas users.txt nerastas. Sukuriamas naujas failas." << endl;
-            ofstream outFile("users.txt");
-            outFile.close();
-            return;
+    size_t append(int id, string_view title, string_view author, int year, string_view category) {
+        size_t row = ids.size();
+        ids.push_back(id);
+        years.push_back(year);
+        categoryCodes.push_back(categories.intern(category));
+        authorCodes.push_back(authors.intern(author));
+        titles.add(title);
+        if ((row & 63) == 0) {
+            availableBits.push_back(0);
         }
-        string name, password;
-        while (inFile >> name >> password) {
-            users.push_back(new User(name, password));
+        if (row % (AvailabilityVersion::BlockRows * 64) == 0) {
+            changedBlocks.push_back(0);
         }
-        inFile.close();
+        availableBits[row >> 6] |= bitOf(row);
+        return row;
     }
 
-    void saveUsersToFile() {
-        ofstream outFile("users.txt");
-        for (const auto& user : users) {
-            outFile << user->getName() << " " << user->getPassword() << endl;
+    // Prijungia library.snap stulpelius ir zodynus tusciai saugyklai; visos knygos laisvos
+    void attach(const snapshot::View& file) {
+        ids.attach(file, snapshot::ItemIDs);
+        years.attach(file, snapshot::Years);
+        categoryCodes.attach(file, snapshot::CategoryCodes);
+        authorCodes.attach(file, snapshot::AuthorCodes);
+        titles.attach(file, snapshot::Titles);
+        authors.attach(file, snapshot::Authors, snapshot::AuthorOrder);
+        categories.attach(file, snapshot::Categories, snapshot::CategoryOrder);
+        size_t rows = size();
+        availableBits.assign((rows + 63) / 64, ~uint64_t(0));
+        if (rows % 64 != 0) availableBits.back() = bitOf(rows) - 1;
+        changedBlocks.assign((blockCount(rows) + 63) / 64, 0);
+    }
+
+    void save(snapshot::Writer& out) const {
+        ids.save(out, snapshot::ItemIDs);
+        years.save(out, snapshot::Years);
+        categoryCodes.save(out, snapshot::CategoryCodes);
+        authorCodes.save(out, snapshot::AuthorCodes);
+        titles.save(out, snapshot::Titles);
+        authors.save(out, snapshot::Authors, snapshot::AuthorOrder);
+        categories.save(out, snapshot::Categories, snapshot::CategoryOrder);
+    }
+
+    size_t size() const { return ids.size(); }
+    // Pirmuju rows eiluciu (ID ten didejantys) eilute su tokiu ID arba rows, jei jos nera
+    size_t findRow(int id, size_t rows) const {
+        const int* it = lower_bound(ids.begin(), ids.begin() + rows, id);
+        return it != ids.begin() + rows && *it == id ? static_cast<size_t>(it - ids.begin()) : rows;
+    }
+    int getID(size_t row) const { return ids[row]; }
+    int getYear(size_t row) const { return years[row]; }
+    uint32_t getCategoryCode(size_t row) const { return categoryCodes[row]; }
+    uint32_t getAuthorCode(size_t row) const { return authorCodes[row]; }
+    string_view getTitle(size_t row) const { return titles.get(row); }
+    string_view getAuthor(size_t row) const { return authors.get(authorCodes[row]); }
+    string_view getCategory(size_t row) const { return categories.get(categoryCodes[row]); }
+    vector<string_view> getCategoryNames() const {
+        vector<string_view> names;
+        for (uint32_t code = 0; code < categories.size(); ++code) names.push_back(categories.get(code));
+        return names;
+    }
+    // Kodas arba StringDictionary::NotFound, jei tokio autoriaus ar zanro kataloge nera
+    uint32_t findAuthorCode(string_view author) const { return authors.find(author); }
+    uint32_t findCategoryCode(string_view category) const { return categories.find(category); }
+
+    // Eiluciu baitai: pavadinimai, skirtingi autoriai ir zanrai
+    size_t stringBytes() const { return titles.bytes() + authors.bytes() + categories.bytes(); }
+    size_t authorCount() const { return authors.size(); }
+
+    // Prieinamumo zodziai keiciami atominemis operacijomis, todel skaitoma irgi atomiskai
+    bool isAvailable(size_t row) const {
+        return (__atomic_load_n(&availableBits[row >> 6], __ATOMIC_ACQUIRE) & bitOf(row)) != 0;
+    }
+
+    // Atomiskai pasiima knyga: true grazina tik tai gijai, kuri bita pakeite is 1 i 0.
+    // Lenktyniaujancias sesijas isskiria pats bitas; tik laimetoja dar skelbia versija
+    // (publishRow, su publishMutex).
+    bool tryBorrow(size_t row) {
+        uint64_t bit = bitOf(row);
+        uint64_t word = __atomic_load_n(&availableBits[row >> 6], __ATOMIC_RELAXED);
+        while (word & bit) {
+            if (__atomic_compare_exchange_n(&availableBits[row >> 6], &word, word & ~bit, true,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+                publishRow(row);
+                return true;
+            }
         }
-        outFile.close();
+        return false;
     }
 
-    void displayItems() const {
-        printTitle("Visos Bibliotekos Knygos");
-        cout << "| ID  | " << left << setw(25) << "Pavadinimas"
-             << "| " << setw(20) << "Autorius"
-             << "| " << setw(4) << "Metai"
-             << "| " << setw(9) << "Zanras"
-             << "| " << setw(7) << "Statusas" << " |" << endl;
-        printLine(80);
-        for (const auto& item : items) {
-            cout << "| " << setw(4) << item->getID() << "|"; // Pridėtas ID
-            item->displayInfo();
+    // Atomiskai grazina knyga
+    void release(size_t row) {
+        __atomic_fetch_or(&availableBits[row >> 6], bitOf(row), __ATOMIC_RELEASE);
+        publishRow(row);
+    }
+
+    void setAvailable(size_t row, bool available) {
+        if (available) {
+            release(row);
+            return;
         }
-        printLine(80);
+        __atomic_fetch_and(&availableBits[row >> 6], ~bitOf(row), __ATOMIC_ACQ_REL);
+        publishRow(row);
     }
 
-    void displayAvailableItems() const {
-        printTitle("Laisvos Knygos");
-        cout << "| ID  | " << left << setw(25) << "Pavadinimas"
-             << "| " << setw(20) << "Autorius"
-             << "| " << setw(4) << "Metai"
-             << "| " << setw(10) << "Zanras"
-             << "| Statusas |" << endl;
-        printLine(80);
+    // Laisvu knygu skaicius - popcount per 64 knygu zodzius
+    size_t countAvailable() const {
+        size_t count = 0;
+        for (const uint64_t& word : availableBits) {
+            count += static_cast<size_t>(__builtin_popcountll(__atomic_load_n(&word, __ATOMIC_RELAXED)));
+        }
+        return count;
+    }
+
+    // Iskviecia f(row) kiekvienai laisvai knygai; praleidziami nuliniai zodziai
+    template <typename Func>
+    void forEachAvailable(Func f, size_t skip = 0, size_t limit = SIZE_MAX) const {
+        forEachSetBit(availableBits.data(), availableBits.size(), 0, skip, limit, f);
+    }
 
-        bool found = false;
-        for (const auto& item : items) {
-            if (item->checkAvailability()) {
-                cout << "| " << setw(4) << item->getID() << "|"; // Spausdiname ID
-                item->displayInfo();
-                found = true;
+    // Iskviecia f(row) kiekvienai knygai eiluciu tvarka
+    template <typename Func>
+    void forEachRow(Func f, size_t skip = 0, size_t limit = SIZE_MAX) const {
+        for (size_t row = skip; row < size() && limit > 0; ++row, --limit) f(row);
+    }
+
+    // Nuoseklus prieinamumo vaizdas be uzraktu (tuscias, kol publish() dar nekviestas)
+    CatalogSnapshot snapshot() const { return CatalogSnapshot(versions); }
+
+    // Paskelbia visa prieinamumo versija is naujo; kvieciama ikelus katalogo duomenis.
+    // Nuo tada prieinamumo pakeitimai skelbiami grupemis (publishRow).
+    void publish() {
+        lock_guard<mutex> lock(publishMutex);
+        for (uint64_t& word : changedBlocks) __atomic_store_n(&word, 0, __ATOMIC_RELAXED);
+        publishedCount = changeCount.load(memory_order_acquire);
+        auto next = make_unique<AvailabilityVersion>();
+        const AvailabilityVersion* previous = versions.current();
+        next->number = previous ? previous->number + 1 : 1;
+        next->rows = size();
+        for (size_t b = 0; b < blockCount(size()); ++b) {
+            next->blocks.push_back(copyBlock(b, size()));
+            next->available += next->blocks.back()->available;
+        }
+        if (previous) {
+            for (const auto* old : previous->blocks) previous->replaced.emplace_back(old);
+        }
+        versions.publish(std::move(next));
+    }
+
+    uint64_t versionNumber() const {
+        const AvailabilityVersion* current = versions.current();
+        return current ? current->number : 0;
+    }
+    size_t retiredVersions() const { return versions.retiredCount(); }
+};
+
+// Didejanciu katalogo eiluciu sarasas be kopijos: rodo i indekso vektoriu ar atvaizduota faila
+struct RowSpan {
+    const uint32_t* first = nullptr;
+    const uint32_t* last = nullptr;
+
+    const uint32_t* begin() const { return first; }
+    const uint32_t* end() const { return last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+    bool empty() const { return first == last; }
+    uint32_t operator[](size_t i) const { return first[i]; }
+};
+
+// Apverstinis indeksas: raktas (zanras ar zodis) -> didejanciu katalogo eiluciu sarasas.
+// Is library.snap atvaizduoti raktai (surusiuoti) ir ju sarasai skaitomi tiesiai is failo;
+// nauji raktai ir papildyti sarasai laikomi maisos lenteleje, kuri tikrinama pirma.
+class InvertedIndex {
+private:
+    unordered_map<string, vector<uint32_t>> postings;
+    const snapshot::String* mappedKeys = nullptr;
+    const uint64_t* mappedOffsets = nullptr;   // Rakto saraso pradzia mappedRows (raktu + 1)
+    const uint32_t* mappedRows = nullptr;
+    string_view mappedText;
+    size_t mappedCount = 0;
+
+    string_view mappedKey(size_t i) const { return mappedText.substr(mappedKeys[i].offset, mappedKeys[i].length); }
+    RowSpan mappedList(size_t i) const { return {mappedRows + mappedOffsets[i], mappedRows + mappedOffsets[i + 1]}; }
+
+    // Atvaizduoto rakto numeris arba mappedCount, jei tokio rakto nera
+    size_t findMapped(string_view key) const {
+        size_t low = 0, high = mappedCount;
+        while (low < high) {
+            size_t middle = low + (high - low) / 2;
+            if (mappedKey(middle) < key) low = middle + 1;
+            else high = middle;
+        }
+        return low < mappedCount && mappedKey(low) == key ? low : mappedCount;
+    }
+
+public:
+    // Eilutes pridedamos didejancia tvarka, todel sarasai lieka surusiuoti. Atvaizduotas
+    // sarasas pirma nukopijuojamas i lentele.
+    void add(const string& key, uint32_t row) {
+        auto [it, inserted] = postings.try_emplace(key);
+        auto& list = it->second;
+        if (inserted && mappedCount > 0) {
+            size_t i = findMapped(key);
+            if (i < mappedCount) list.assign(mappedList(i).begin(), mappedList(i).end());
+        }
+        if (list.empty() || list.back() < row) list.push_back(row);
+        else if (!binary_search(list.begin(), list.end(), row)) list.insert(lower_bound(list.begin(), list.end(), row), row);
+    }
+
+    // Rakto eilutes; false, jei tokio rakto nera
+    bool find(const string& key, RowSpan& rows) const {
+        auto it = postings.find(key);
+        if (it != postings.end()) {
+            rows = {it->second.data(), it->second.data() + it->second.size()};
+            return true;
+        }
+        size_t i = mappedCount > 0 ? findMapped(key) : mappedCount;
+        if (i == mappedCount) return false;
+        rows = mappedList(i);
+        return true;
+    }
+
+    // Kvieciama tusciam indeksui
+    void attach(const snapshot::View& file, snapshot::Section keys, snapshot::Section offsets,
+                snapshot::Section rows) {
+        mappedKeys = file.items<snapshot::String>(keys);
+        mappedOffsets = file.items<uint64_t>(offsets);
+        mappedRows = file.items<uint32_t>(rows);
+        mappedText = file.strings;
+        mappedCount = file.count(keys);
+    }
+
+    // Visi raktai surusiuoti; atvaizduotas sarasas rasomas, jei jo nepakeite lentele
+    void save(snapshot::Writer& out, snapshot::Section keys, snapshot::Section offsets, snapshot::Section rows) const {
+        vector<pair<string_view, RowSpan>> lists;
+        lists.reserve(mappedCount + postings.size());
+        for (size_t i = 0; i < mappedCount; ++i) {
+            if (!postings.count(string(mappedKey(i)))) lists.emplace_back(mappedKey(i), mappedList(i));
+        }
+        for (const auto& entry : postings) {
+            lists.emplace_back(entry.first, RowSpan{entry.second.data(), entry.second.data() + entry.second.size()});
+        }
+        sort(lists.begin(), lists.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        vector<snapshot::String> keyRefs;
+        vector<uint64_t> starts{0};
+        vector<uint32_t> allRows;
+        for (const auto& [key, list] : lists) {
+            keyRefs.push_back(out.add(key));
+            allRows.insert(allRows.end(), list.begin(), list.end());
+            starts.push_back(allRows.size());
+        }
+        out.put(keys, keyRefs);
+        out.put(offsets, starts);
+        out.put(rows, allRows);
+    }
+};
+
+// Prefiksu indeksas: irasai (rakto ID, zodzio pradzia rakte, eilute) surusiuoti pagal rakto
+// teksta nuo zodzio pradzios. Kiekvienam rakto zodziui skiriamas irasas, todel "sekspyr" randa
+// "Viljamas Sekspyras". Raktai - pavadinimu ir autoriu zodynu ID (zodynai turi gyventi ilgiau
+// uz indeksa); irasai vienodi atmintyje ir library.snap, todel atvaizduoti naudojami tiesiogiai.
+// Prefiksas randamas dvejetaine paieska, o atitikmenys eina vienas po kito.
+class PrefixIndex {
+public:
+    enum Source : uint32_t { Title, Author };  // Rakto zodynas
+
+private:
+    struct Entry {
+        uint32_t key;    // Rakto ID; auksciausias bitas - autoriaus raktas
+        uint32_t start;  // Zodzio pradzia rakte
+        uint32_t row;
+    };
+    static_assert(sizeof(Entry) == 12, "irasas library.snap faile - 12 baitu");
+    static constexpr uint32_t AuthorBit = uint32_t(1) << 31;
+
+    const StringDictionary* dictionaries[2];
+    mutable Column<Entry> entries;
+    mutable atomic<size_t> sortedCount{0};  // Surusiuota entries pradzia
+    mutable mutex sortMutex;
+
+    string_view keyOf(const Entry& entry) const {
+        return dictionaries[entry.key >> 31]->get(entry.key & ~AuthorBit).substr(entry.start);
+    }
+
+    bool less(const Entry& a, const Entry& b) const {
+        int order = keyOf(a).compare(keyOf(b));
+        return order != 0 ? order < 0 : a.row < b.row;
+    }
+
+public:
+    PrefixIndex(const StringDictionary& titles, const StringDictionary& authors) : dictionaries{&titles, &authors} {}
+    PrefixIndex(const PrefixIndex& other) : dictionaries{other.dictionaries[0], other.dictionaries[1]} {
+        other.ensureSorted();
+        entries = other.entries;
+        sortedCount.store(entries.size(), memory_order_relaxed);
+    }
+    PrefixIndex& operator=(const PrefixIndex&) = delete;
+
+    // Irasai pridedami nerusiuojant; nauji surusiuojami ir sujungiami su jau surusiuota
+    // dalimi ikelus, pries paskelbiant indeksus arba pries pirma paieska
+    void ensureSorted() const {
+        if (sortedCount.load(memory_order_acquire) == entries.size()) return;
+        lock_guard<mutex> lock(sortMutex);
+        size_t done = sortedCount.load(memory_order_relaxed);
+        if (done == entries.size()) return;
+        vector<Entry>& list = entries.edit();
+        auto middle = list.begin() + static_cast<ptrdiff_t>(done);
+        // Rusiuojant raktai palyginami daug kartu, todel zodynuose randami is anksto
+        vector<pair<string_view, Entry>> keyed;
+        keyed.reserve(static_cast<size_t>(list.end() - middle));
+        for (auto it = middle; it != list.end(); ++it) keyed.emplace_back(keyOf(*it), *it);
+        sort(keyed.begin(), keyed.end(), [](const pair<string_view, Entry>& a, const pair<string_view, Entry>& b) {
+            int order = a.first.compare(b.first);
+            return order != 0 ? order < 0 : a.second.row < b.second.row;
+        });
+        for (size_t i = 0; i < keyed.size(); ++i) middle[static_cast<ptrdiff_t>(i)] = keyed[i].second;
+        inplace_merge(list.begin(), middle, list.end(), [this](const Entry& a, const Entry& b) { return less(a, b); });
+        sortedCount.store(list.size(), memory_order_release);
+    }
+
+    // Kvieciama tik kai lygiagreciu paiesku nera (kaip ir kitu indeksu keitimas)
+    void add(Source source, uint32_t id, uint32_t row) {
+        string_view key = dictionaries[source]->get(id);
+        for (size_t i = 0; i < key.size(); ++i) {
+            if (key[i] == ' ' || (i > 0 && key[i - 1] != ' ')) continue; // Tik zodziu pradzios
+            Entry entry{source == Author ? id | AuthorBit : id, static_cast<uint32_t>(i), row};
+            bool inOrder = sortedCount.load(memory_order_relaxed) == entries.size()
+                           && (entries.empty() || less(entries.back(), entry));
+            entries.push_back(entry);
+            if (inOrder) sortedCount.store(entries.size(), memory_order_relaxed);
+        }
+    }
+
+    // Kvieciama tusciam indeksui
+    void attach(const snapshot::View& file, snapshot::Section section) {
+        entries.attach(file, section);
+        sortedCount.store(entries.size(), memory_order_relaxed);
+    }
+
+    void save(snapshot::Writer& out, snapshot::Section section) const {
+        ensureSorted();
+        entries.save(out, section);
+    }
+
+    // Iskviecia f(row) raktams, prasidedantiems prefix, rakto tvarka, kol f grazina true
+    template <typename Func>
+    void forEachWithPrefix(string_view prefix, Func f) const {
+        ensureSorted();
+        auto it = lower_bound(entries.begin(), entries.end(), prefix, [&](const Entry& entry, string_view value) {
+            return keyOf(entry) < value;
+        });
+        for (; it != entries.end() && keyOf(*it).substr(0, prefix.size()) == prefix; ++it) {
+            if (!f(it->row)) return;
+        }
+    }
+};
+
+// Tvarkingas metu indeksas: irasai (grupe, metai, eilute) surusiuoti, todel metu intervalas
+// randamas dvejetaine paieska, o puslapis - poslinkiu nuo intervalo pradzios.
+// Grupe - zanro rakto ID (arba 0, kai indeksuojami tik metai). Nauji irasai pridedami gale
+// ir pries kita paieska surusiuojami bei sujungiami su jau surusiuota dalimi.
+class YearIndex {
+private:
+    struct Entry {
+        uint32_t group;
+        int32_t year;
+        uint32_t row;
+
+        bool operator<(const Entry& other) const {
+            return tie(group, year, row) < tie(other.group, other.year, other.row);
+        }
+    };
+    static_assert(sizeof(Entry) == 12, "irasas library.snap faile - 12 baitu");
+    mutable Column<Entry> entries;
+    mutable atomic<size_t> sortedCount{0};  // Surusiuota entries pradzia
+    mutable mutex sortMutex;
+
+    // Grupes irasai, kuriu metai tarp fromYear ir toYear (imtinai)
+    pair<const Entry*, const Entry*> range(uint32_t group, int fromYear, int toYear) const {
+        ensureSorted();
+        if (fromYear > toYear) return {entries.end(), entries.end()};
+        auto first = lower_bound(entries.begin(), entries.end(), Entry{group, fromYear, 0});
+        auto last = upper_bound(first, entries.end(), Entry{group, toYear, UINT32_MAX});
+        return {first, last};
+    }
+
+public:
+    YearIndex() = default;
+    YearIndex(const YearIndex& other) {
+        other.ensureSorted();
+        entries = other.entries;
+        sortedCount.store(entries.size(), memory_order_relaxed);
+    }
+    YearIndex& operator=(const YearIndex&) = delete;
+
+    void ensureSorted() const {
+        if (sortedCount.load(memory_order_acquire) == entries.size()) return;
+        lock_guard<mutex> lock(sortMutex);
+        size_t done = sortedCount.load(memory_order_relaxed);
+        if (done == entries.size()) return;
+        vector<Entry>& list = entries.edit();
+        auto middle = list.begin() + static_cast<ptrdiff_t>(done);
+        sort(middle, list.end());
+        inplace_merge(list.begin(), middle, list.end());
+        sortedCount.store(list.size(), memory_order_release);
+    }
+
+    // Kvieciama tik kai lygiagreciu paiesku nera (kaip ir kitu indeksu keitimas)
+    void add(uint32_t group, int year, uint32_t row) {
+        Entry entry{group, year, row};
+        bool inOrder = sortedCount.load(memory_order_relaxed) == entries.size()
+                       && (entries.empty() || entries.back() < entry);
+        entries.push_back(entry);
+        if (inOrder) sortedCount.store(entries.size(), memory_order_relaxed);
+    }
+
+    // Kvieciama tusciam indeksui
+    void attach(const snapshot::View& file, snapshot::Section section) {
+        entries.attach(file, section);
+        sortedCount.store(entries.size(), memory_order_relaxed);
+    }
+
+    void save(snapshot::Writer& out, snapshot::Section section) const {
+        ensureSorted();
+        entries.save(out, section);
+    }
+
+    size_t count(uint32_t group, int fromYear, int toYear) const {
+        auto [first, last] = range(group, fromYear, toYear);
+        return static_cast<size_t>(last - first);
+    }
+
+    // Iskviecia f(row) intervalo irasams metu tvarka (tie patys metai - eiluciu tvarka),
+    // praleidus pirmus skip ir ne daugiau kaip limit
+    template <typename Func>
+    void forEachInRange(uint32_t group, int fromYear, int toYear, size_t skip, size_t limit, Func f) const {
+        auto [first, last] = range(group, fromYear, toYear);
+        if (skip >= static_cast<size_t>(last - first)) return;
+        first += static_cast<ptrdiff_t>(skip);
+        for (; first != last && limit > 0; ++first, --limit) f(first->row);
+    }
+};
+
+// Funkcija tekstui isskaidyti i normalizuotus zodzius (raides ir skaitmenys; UTF-8 baitai laikomi raidemis)
+vector<string> tokenize(string_view text) {
+    vector<string> words;
+    string word;
+    for (char c : text) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (isalnum(u) || u >= 0x80) {
+            word += static_cast<char>(tolower(u));
+        } else if (!word.empty()) {
+            words.push_back(std::move(word));
+            word.clear();
+        }
+    }
+    if (!word.empty()) words.push_back(std::move(word));
+    sort(words.begin(), words.end());
+    words.erase(unique(words.begin(), words.end()), words.end());
+    return words;
+}
+
+// Funkcija surusiuotu sarasu sankirtai rasti. Pradedama nuo trumpiausio saraso,
+// o kituose ieskoma dvejetaine paieska nuo paskutines rastos vietos.
+vector<uint32_t> intersectPostings(vector<RowSpan> lists) {
+    vector<uint32_t> result;
+    if (lists.empty()) return result;
+    sort(lists.begin(), lists.end(), [](const RowSpan& a, const RowSpan& b) { return a.size() < b.size(); });
+    vector<const uint32_t*> cursors;
+    for (const RowSpan& list : lists) cursors.push_back(list.begin());
+    for (uint32_t row : lists[0]) {
+        bool inAll = true;
+        for (size_t i = 1; i < lists.size() && inAll; ++i) {
+            cursors[i] = lower_bound(cursors[i], lists[i].end(), row);
+            if (cursors[i] == lists[i].end()) return result;
+            inAll = *cursors[i] == row;
+        }
+        if (inAll) result.push_back(row);
+    }
+    return result;
+}
+
+// Rankena i objekta telkinyje: lizdo indeksas ir kartos numeris.
+// Atlaisvinus lizda kartos numeris didinamas, todel senos rankenos tampa negaliojancios.
+template <typename T>
+struct Handle {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool valid() const { return index != UINT32_MAX; }
+    bool operator==(const Handle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Handle& other) const { return !(*this == other); }
+};
+
+// Tipizuotas objektu telkinys. Objektai laikomi fiksuoto dydzio blokuose (ju adresai nekinta),
+// atlaisvinti lizdai pakartotinai naudojami, todel daznas kurimas ir naikinimas nesikreipia
+// i bendra atminties skirstytuva.
+template <typename T>
+class ObjectPool {
+private:
+    static const uint32_t BlockSize = 1024;
+
+    struct Slot {
+        alignas(T) unsigned char storage[sizeof(T)];
+        uint32_t generation = 0;
+        bool live = false;
+    };
+
+    vector<unique_ptr<Slot[]>> blocks;
+    vector<uint32_t> freeSlots;   // Atlaisvinti lizdai pakartotiniam naudojimui
+    uint32_t slotCount = 0;       // Kiek lizdu kada nors panaudota
+    size_t liveCount = 0;
+
+    Slot& slot(uint32_t index) const { return blocks[index / BlockSize][index % BlockSize]; }
+    static T* object(Slot& s) { return std::launder(reinterpret_cast<T*>(s.storage)); }
+
+public:
+    ObjectPool() = default;
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    ~ObjectPool() {
+        for (uint32_t i = 0; i < slotCount; ++i) {
+            Slot& s = slot(i);
+            if (s.live) object(s)->~T();
+        }
+    }
+
+    template <typename... Args>
+    Handle<T> create(Args&&... args) {
+        uint32_t index;
+        if (!freeSlots.empty()) {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            if (slotCount % BlockSize == 0) blocks.emplace_back(new Slot[BlockSize]);
+            index = slotCount++;
+        }
+        Slot& s = slot(index);
+        try {
+            new (s.storage) T(std::forward<Args>(args)...);
+        } catch (...) {
+            freeSlots.push_back(index);
+            throw;
+        }
+        s.live = true;
+        ++liveCount;
+        return Handle<T>{index, s.generation};
+    }
+
+    // Grazina false, jei rankena jau negalioja
+    bool destroy(Handle<T> handle) {
+        T* obj = get(handle);
+        if (!obj) return false;
+        obj->~T();
+        Slot& s = slot(handle.index);
+        s.live = false;
+        ++s.generation;
+        freeSlots.push_back(handle.index);
+        --liveCount;
+        return true;
+    }
+
+    // Objektas arba nullptr, jei rankena negalioja (pasenusi karta)
+    T* get(Handle<T> handle) const {
+        if (handle.index >= slotCount) return nullptr;
+        Slot& s = slot(handle.index);
+        return s.live && s.generation == handle.generation ? object(s) : nullptr;
+    }
+
+    // Iskviecia f(rankena, objektas) kiekvienam gyvam objektui lizdu tvarka
+    template <typename Func>
+    void forEach(Func f) const {
+        for (uint32_t i = 0; i < slotCount; ++i) {
+            Slot& s = slot(i);
+            if (s.live) f(Handle<T>{i, s.generation}, *object(s));
+        }
+    }
+
+    size_t size() const { return liveCount; }
+    size_t capacity() const { return blocks.size() * BlockSize; }
+
+    // Telkinio uzimama atmintis (lizdai ir laisvu lizdu sarasas, be objektu vidiniu eiluciu)
+    size_t memoryBytes() const {
+        return capacity() * sizeof(Slot) + freeSlots.capacity() * sizeof(uint32_t)
+               + blocks.capacity() * sizeof(unique_ptr<Slot[]>);
+    }
+
+    static constexpr size_t slotBytes() { return sizeof(Slot); }
+};
+
+// Bazine klase LibraryItem - bendra visu leidiniu dalis be virtualiu funkciju.
+// Objektas tik rodo i eilute CatalogStore saugykloje; duomenys laikomi stulpeliuose.
+// Konkrecios rusys (Book, Magazine, DVD) laikomos CatalogItem variante.
+class LibraryItem {
+protected:
+    static int nextID;      // Kitos knygos unikalus ID
+    CatalogStore* store;    // Saugykla, kurioje laikomi knygos duomenys
+    size_t row;             // Knygos eilute saugykloje
+
+public:
+    LibraryItem(CatalogStore& store, string_view title, string_view author, int year, string_view category)
+            : store(&store), row(store.append(nextID++, title, author, year, category)) {
+        // Unikalus ID priskiriamas pridedant eilute ir didinamas
+    }
+
+    // Jau esanti saugyklos eilute (pvz., is library.snap); jos ID nebebus priskirtas naujai knygai
+    LibraryItem(CatalogStore& store, size_t row) : store(&store), row(row) {
+        nextID = max(nextID, store.getID(row) + 1);
+    }
+
+    bool checkAvailability() const {
+        return store->isAvailable(row);
+    }
+
+    // Grazina false, jei knyga jau paeme kita sesija
+    bool borrowItem() {
+        return store->tryBorrow(row);
+    }
+
+    void returnItem() {
+        store->release(row);
+    }
+
+    size_t getRow() const { return row; }
+    int getID() const { return store->getID(row); } // Naujas metodas ID gavimui
+    int getYear() const { return store->getYear(row); }
+    string_view getTitle() const { return store->getTitle(row); }
+    string_view getAuthor() const { return store->getAuthor(row); }
+    string_view getCategory() const { return store->getCategory(row); }
+    uint32_t getAuthorCode() const { return store->getAuthorCode(row); }
+    uint32_t getCategoryCode() const { return store->getCategoryCode(row); }
+
+protected:
+    // Bendra lenteles eilute; title - pavadinimas su rusies informacija, available - busena
+    // is skaitytojo vaizdo (CatalogSnapshot)
+    void renderRow(OutputBuffer& out, string_view title, bool available) const {
+        out.padded(title, 25)
+           .text("| ").padded(getAuthor(), 20)
+           .text("| ").paddedNumber(getYear(), 4, true).text(" ")
+           .text("| ").padded(getCategory(), 10)
+           .text("| ").padded(available ? "Laisva" : "Uzimta", 7).text(" |");
+        out.endLine();
+    }
+};
+
+// Inicializuojame static ID
+int LibraryItem::nextID = 1;
+
+// Leidinio rusis; skaicius sutampa su CatalogItem alternatyvos indeksu
+enum class ItemKind : uint8_t { Book, Magazine, DVD };
+
+// Rusies pavadinimas books.txt faile
+const char* itemKindName(ItemKind kind) {
+    static const char* const names[] = {"knyga", "zurnalas", "dvd"};
+    return names[static_cast<size_t>(kind)];
+}
+
+bool parseItemKind(string_view text, ItemKind& kind) {
+    for (ItemKind candidate : {ItemKind::Book, ItemKind::Magazine, ItemKind::DVD}) {
+        if (text == itemKindName(candidate)) {
+            kind = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Knygos klase, paveldi LibraryItem
+class Book : public LibraryItem {
+public:
+    Book(CatalogStore& store, string_view title, string_view author, int year, string_view category)
+            : LibraryItem(store, title, author, year, category) {}
+    Book(CatalogStore& store, size_t row) : LibraryItem(store, row) {}
+
+    int getDetail() const { return 0; }
+
+    void render(OutputBuffer& out, bool available) const {
+        renderRow(out, getTitle(), available);
+    }
+};
+
+// Zurnalo klase: papildomai saugomas numeris
+class Magazine : public LibraryItem {
+private:
+    int issue;
+
+public:
+    Magazine(CatalogStore& store, string_view title, string_view author, int year, string_view category, int issue)
+            : LibraryItem(store, title, author, year, category), issue(issue) {}
+    Magazine(CatalogStore& store, size_t row, int issue) : LibraryItem(store, row), issue(issue) {}
+
+    int getIssue() const { return issue; }
+    int getDetail() const { return issue; }
+
+    void render(OutputBuffer& out, bool available) const {
+        renderRow(out, string(getTitle()) + " Nr. " + to_string(issue), available);
+    }
+};
+
+// DVD klase: papildomai saugoma trukme minutemis
+class DVD : public LibraryItem {
+private:
+    int minutes;
+
+public:
+    DVD(CatalogStore& store, string_view title, string_view author, int year, string_view category, int minutes)
+            : LibraryItem(store, title, author, year, category), minutes(minutes) {}
+    DVD(CatalogStore& store, size_t row, int minutes) : LibraryItem(store, row), minutes(minutes) {}
+
+    int getMinutes() const { return minutes; }
+    int getDetail() const { return minutes; }
+
+    void render(OutputBuffer& out, bool available) const {
+        renderRow(out, string(getTitle()) + " (" + to_string(minutes) + " min)", available);
+    }
+};
+
+// Uzdaras leidiniu rinkinys, laikomas pagal reiksme: rusis parenkama per std::visit
+// (switch pagal indeksa), todel nera virtualiu kvietimu ir atskiru objektu krūvoje
+using CatalogItem = variant<Book, Magazine, DVD>;
+
+inline const LibraryItem& asItem(const CatalogItem& item) {
+    return visit([](const LibraryItem& base) -> const LibraryItem& { return base; }, item);
+}
+
+inline LibraryItem& asItem(CatalogItem& item) {
+    return visit([](LibraryItem& base) -> LibraryItem& { return base; }, item);
+}
+
+inline ItemKind kindOf(const CatalogItem& item) {
+    return static_cast<ItemKind>(item.index());
+}
+
+// Rusies papildomas laukas: zurnalo numeris, DVD trukme (knygai - 0)
+inline int detailOf(const CatalogItem& item) {
+    return visit([](const auto& kind) { return kind.getDetail(); }, item);
+}
+
+inline void renderItem(OutputBuffer& out, const CatalogItem& item, bool available) {
+    visit([&](const auto& kind) { kind.render(out, available); }, item);
+}
+
+void displayItem(const CatalogItem& item) {
+    OutputBuffer out(cout);
+    renderItem(out, item, asItem(item).checkAvailability());
+}
+
+// Vartotojo klase
+class User {
+private:
+    string name;  // Vartotojo vardas
+    string password; // Vartotojo slaptažodis
+
+public:
+    User(string name, string password) : name(std::move(name)), password(std::move(password)) {}
+
+    void displayUserInfo() const {
+        cout << "| Vardas: " << setw(15) << name << " |" << endl;
+    }
+
+    const string& getName() const { return name; }
+    const string& getPassword() const { return password; }
+};
+
+using ItemHandle = Handle<CatalogItem>;
+using UserHandle = Handle<User>;
+
+// Rezervacijos klase. Vartotojas ir knyga saugomi kaip rankenos i bibliotekos telkinius,
+// laikai - kaip epochos sekundes (tekstas formuojamas tik rodant ir rasant i failus).
+class Reservation {
+private:
+    UserHandle user;
+    ItemHandle item;
+    time_t reservedAt;  // Rezervacijos laikas
+    time_t returnBy;    // Atsiimti iki
+    Handle<Reservation> previousOfUser;  // Kaimynes to paties vartotojo rezervaciju sarase
+    Handle<Reservation> nextOfUser;
+
+public:
+    static const time_t PickupWindowSeconds = 10 * 24 * 60 * 60; // 10 dienu
+
+    // Pagrindinis konstruktorius (automatinė data)
+    Reservation(UserHandle user, ItemHandle item)
+            : user(user), item(item),
+              reservedAt(chrono::system_clock::to_time_t(chrono::system_clock::now())),
+              returnBy(reservedAt + PickupWindowSeconds) {}
+
+    // Konstruktorius su konkrečiomis datomis
+    Reservation(UserHandle user, ItemHandle item, time_t reservedAt, time_t returnBy)
+            : user(user), item(item), reservedAt(reservedAt), returnBy(returnBy) {}
+
+    void displayReservationInfo(const User& owner, const CatalogItem& reservedItem) const {
+        printTitle("Rezervacijos informacija");
+        cout << "Rezervacijos data: " << formatTime(reservedAt) << endl;
+        cout << "Atsiimti iki: " << formatTime(returnBy) << endl;
+        owner.displayUserInfo();
+        printLine();
+        displayItem(reservedItem);
+        printLine();
+    }
+
+    UserHandle getUser() const { return user; }
+    ItemHandle getItem() const { return item; }
+
+    time_t getReservedAt() const { return reservedAt; }
+    time_t getReturnBy() const { return returnBy; }
+
+    Handle<Reservation> getPreviousOfUser() const { return previousOfUser; }
+    Handle<Reservation> getNextOfUser() const { return nextOfUser; }
+    void setPreviousOfUser(Handle<Reservation> handle) { previousOfUser = handle; }
+    void setNextOfUser(Handle<Reservation> handle) { nextOfUser = handle; }
+
+    string getReservationDate() const {
+        return formatTime(reservedAt);
+    }
+
+    string getReturnDate() const {
+        return formatTime(returnBy);
+    }
+};
+
+using ReservationHandle = Handle<Reservation>;
+
+// Laukimo eiles irasas: vartotojas laukia uzimtos knygos. Irasas yra dviejuose dvikrypciuose
+// sarasuose - knygos eileje (FIFO) ir vartotojo laukimu sarase; nuorodos laikomos paciame irase.
+class Hold {
+private:
+    UserHandle user;
+    ItemHandle item;
+    time_t requestedAt;  // Kada istota i eile
+    Handle<Hold> previousInQueue;
+    Handle<Hold> nextInQueue;
+    Handle<Hold> previousOfUser;
+    Handle<Hold> nextOfUser;
+
+public:
+    Hold(UserHandle user, ItemHandle item, time_t requestedAt) : user(user), item(item), requestedAt(requestedAt) {}
+
+    UserHandle getUser() const { return user; }
+    ItemHandle getItem() const { return item; }
+    time_t getRequestedAt() const { return requestedAt; }
+
+    Handle<Hold> getPreviousInQueue() const { return previousInQueue; }
+    Handle<Hold> getNextInQueue() const { return nextInQueue; }
+    Handle<Hold> getPreviousOfUser() const { return previousOfUser; }
+    Handle<Hold> getNextOfUser() const { return nextOfUser; }
+    void setPreviousInQueue(Handle<Hold> handle) { previousInQueue = handle; }
+    void setNextInQueue(Handle<Hold> handle) { nextInQueue = handle; }
+    void setPreviousOfUser(Handle<Hold> handle) { previousOfUser = handle; }
+    void setNextOfUser(Handle<Hold> handle) { nextOfUser = handle; }
+};
+
+using HoldHandle = Handle<Hold>;
+
+// Funkcija visiems duomenims irasyti i fd (kartojama po dalinio irasymo ir EINTR)
+bool writeFully(int fd, const string& data) {
+    const char* p = data.data();
+    size_t left = data.size();
+    while (left > 0) {
+        ssize_t written = ::write(fd, p, left);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += written;
+        left -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// Funkcija failo turiniui issaugoti diske (fsync)
+bool syncFile(const string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+// Zurnalo sinchronizavimo su disku politika
+enum class FsyncPolicy {
+    Never,  // Paliekama operacinei sistemai
+    Batch,  // fsync kas syncBatchSize irasu ir per sync()
+    Always  // fsync po kiekvieno iraso
+};
+
+// Rezervaciju zurnalo nustatymai
+struct JournalConfig {
+    FsyncPolicy fsyncPolicy = FsyncPolicy::Always;
+    size_t syncBatchSize = 64;                     // Irasu skaicius tarp fsync (Batch rezimu)
+    size_t compactThresholdBytes = 1024 * 1024;    // Virsijus si dydi, zurnalas suspaudziamas i reservations.txt
+};
+
+// Rezervaciju zurnalas - tik papildomas failas su rezervavimo (+) ir atsaukimo (-) irasais
+class ReservationJournal {
+private:
+    string path;
+    int fd = -1;
+    size_t bytes = 0;        // Dabartinis zurnalo dydis
+    size_t unsynced = 0;     // Irasai, dar neissaugoti su fsync
+    JournalConfig config;
+
+public:
+    ~ReservationJournal() {
+        close();
+    }
+
+    bool open(const string& journalPath, const JournalConfig& journalConfig) {
+        close();
+        path = journalPath;
+        config = journalConfig;
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) return false;
+        off_t end = ::lseek(fd, 0, SEEK_END);
+        bytes = end > 0 ? static_cast<size_t>(end) : 0;
+        return true;
+    }
+
+    void close() {
+        if (fd < 0) return;
+        sync();
+        ::close(fd);
+        fd = -1;
+    }
+
+    // Iraso count irasu grupe (eilutes su '\n') vienu write ir sinchronizuoja pagal politika;
+    // grazina false, jei irasyti nepavyko
+    bool append(const string& records, size_t count) {
+        if (fd < 0) return false;
+        if (!writeFully(fd, records)) return false;
+        bytes += records.size();
+        unsynced += count;
+        if (config.fsyncPolicy == FsyncPolicy::Always ||
+            (config.fsyncPolicy == FsyncPolicy::Batch && unsynced >= config.syncBatchSize)) {
+            sync();
+        }
+        return true;
+    }
+
+    void sync() {
+        if (fd < 0 || unsynced == 0) return;
+        if (config.fsyncPolicy != FsyncPolicy::Never) ::fsync(fd);
+        unsynced = 0;
+    }
+
+    // Isvalo zurnala (po suspaudimo i reservations.txt)
+    void reset() {
+        if (fd < 0) return;
+        if (::ftruncate(fd, 0) == 0) {
+            bytes = 0;
+            unsynced = 0;
+            if (config.fsyncPolicy != FsyncPolicy::Never) ::fsync(fd);
+        }
+    }
+
+    bool needsCompaction() const {
+        return bytes >= config.compactThresholdBytes;
+    }
+
+    bool empty() const { return bytes == 0; }
+
+    const string& getPath() const { return path; }
+};
+
+// Funkcija turiniui atomiskai irasyti: laikinas failas, fsync, rename
+bool writeFileAtomically(const string& path, const string& contents) {
+    const string tmpPath = path + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    if (!writeFully(fd, contents)) {
+        ::close(fd);
+        return false;
+    }
+    bool ok = ::fsync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+    return ok && rename(tmpPath.c_str(), path.c_str()) == 0;
+}
+
+// Matuojamos bibliotekos operacijos
+enum class Operation {
+    Load, Login, Reserve, Cancel, Hold, Filter, Complete, YearRange, Import, Export, SaveUsers, SaveReservations,
+    SaveSnapshot, Count
+};
+
+const char* operationName(Operation operation) {
+    static const char* const names[] = {
+        "load", "login", "reserve", "cancel", "hold", "filter", "complete", "year_range", "import", "export",
+        "save_users", "save_reservations", "save_snapshot"};
+    return names[static_cast<size_t>(operation)];
+}
+
+// Operaciju metrikos: skaitikliai, nesekmes, irasyti baitai ir trukmiu histograma su log2 intervalais.
+// Kai metrikos isjungtos, matuojant tikrinama tik viena veliava (laikrodis neskaitomas).
+class Metrics {
+public:
+    static constexpr size_t FirstBucketLog2 = 8;   // Pirmas intervalas - iki 256 ns
+    static constexpr size_t BucketCount = 29;      // Paskutinis - iki 2^36 ns (~69 s)
+
+private:
+    struct OperationStats {
+        atomic<uint64_t> count{0};
+        atomic<uint64_t> failures{0};
+        atomic<uint64_t> totalNanos{0};
+        atomic<uint64_t> bytes{0};
+        atomic<uint64_t> buckets[BucketCount] = {};
+    };
+
+    bool enabled = false;
+    OperationStats stats[static_cast<size_t>(Operation::Count)];
+
+public:
+    // Ijungiama pries paleidziant gijas
+    void enable() { enabled = true; }
+    bool isEnabled() const { return enabled; }
+
+    void record(Operation operation, uint64_t nanos, bool failed) {
+        OperationStats& op = stats[static_cast<size_t>(operation)];
+        op.count.fetch_add(1, memory_order_relaxed);
+        if (failed) op.failures.fetch_add(1, memory_order_relaxed);
+        op.totalNanos.fetch_add(nanos, memory_order_relaxed);
+        size_t bucket = bucketOf(nanos);
+        if (bucket < BucketCount) op.buckets[bucket].fetch_add(1, memory_order_relaxed);
+    }
+
+    // Intervalas b apima (2^(b+7), 2^(b+8)] ns, kaip reikalauja Prometheus le: riba
+    // priklauso zemesniam intervalui, todel imamas bit_width(nanos - 1)
+    static constexpr size_t bucketOf(uint64_t nanos) {
+        size_t bits = nanos > 1 ? 64 - static_cast<size_t>(__builtin_clzll(nanos - 1)) : 0;
+        return bits > FirstBucketLog2 ? bits - FirstBucketLog2 : 0;
+    }
+
+    void addBytes(Operation operation, uint64_t bytes) {
+        if (enabled) stats[static_cast<size_t>(operation)].bytes.fetch_add(bytes, memory_order_relaxed);
+    }
+
+    // Prometheus tekstinis formatas
+    string render() const {
+        string out;
+        char number[32];
+        auto seconds = [&](double value) {
+            snprintf(number, sizeof(number), "%.9g", value);
+            return string(number);
+        };
+        out += "# HELP biblioteka_operation_duration_seconds Bibliotekos operaciju trukme.\n";
+        out += "# TYPE biblioteka_operation_duration_seconds histogram\n";
+        for (size_t i = 0; i < static_cast<size_t>(Operation::Count); ++i) {
+            const OperationStats& op = stats[i];
+            string label = string("op=\"") + operationName(static_cast<Operation>(i)) + "\"";
+            uint64_t cumulative = 0;
+            for (size_t b = 0; b < BucketCount; ++b) {
+                cumulative += op.buckets[b].load(memory_order_relaxed);
+                double le = static_cast<double>(uint64_t(1) << (b + FirstBucketLog2)) / 1e9;
+                out += "biblioteka_operation_duration_seconds_bucket{" + label + ",le=\"" + seconds(le) + "\"} "
+                       + to_string(cumulative) + "\n";
+            }
+            uint64_t count = op.count.load(memory_order_relaxed);
+            out += "biblioteka_operation_duration_seconds_bucket{" + label + ",le=\"+Inf\"} " + to_string(count) + "\n";
+            out += "biblioteka_operation_duration_seconds_sum{" + label + "} "
+                   + seconds(static_cast<double>(op.totalNanos.load(memory_order_relaxed)) / 1e9) + "\n";
+            out += "biblioteka_operation_duration_seconds_count{" + label + "} " + to_string(count) + "\n";
+        }
+        out += "# HELP biblioteka_operation_failures_total Nesekmingos operacijos.\n";
+        out += "# TYPE biblioteka_operation_failures_total counter\n";
+        for (size_t i = 0; i < static_cast<size_t>(Operation::Count); ++i) {
+            out += string("biblioteka_operation_failures_total{op=\"") + operationName(static_cast<Operation>(i)) + "\"} "
+                   + to_string(stats[i].failures.load(memory_order_relaxed)) + "\n";
+        }
+        out += "# HELP biblioteka_save_bytes_total Issaugojimo metu irasyti baitai.\n";
+        out += "# TYPE biblioteka_save_bytes_total counter\n";
+        for (Operation op : {Operation::SaveUsers, Operation::SaveReservations, Operation::SaveSnapshot}) {
+            out += string("biblioteka_save_bytes_total{op=\"") + operationName(op) + "\"} "
+                   + to_string(stats[static_cast<size_t>(op)].bytes.load(memory_order_relaxed)) + "\n";
+        }
+        return out;
+    }
+};
+
+Metrics metrics;
+
+// Matuoja operacijos trukme nuo sukurimo iki sunaikinimo
+class OperationTimer {
+private:
+    Operation operation;
+    bool active;
+    bool failed = false;
+    chrono::steady_clock::time_point start;
+
+public:
+    explicit OperationTimer(Operation operation) : operation(operation), active(metrics.isEnabled()) {
+        if (active) start = chrono::steady_clock::now();
+    }
+
+    OperationTimer(const OperationTimer&) = delete;
+    OperationTimer& operator=(const OperationTimer&) = delete;
+
+    ~OperationTimer() {
+        if (!active) return;
+        auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start);
+        metrics.record(operation, static_cast<uint64_t>(elapsed.count()), failed);
+    }
+
+    void setFailed(bool value) { failed = value; }
+};
+
+static_assert(Metrics::bucketOf(256) == 0 && Metrics::bucketOf(257) == 1 && Metrics::bucketOf(512) == 1 &&
+              Metrics::bucketOf(513) == 2 && Metrics::bucketOf(0) == 0, "ribos turi priklausyti zemesniam intervalui");
+
+// Periodiskai raso metrikas i faila foninėje gijoje; stop() iraso paskutini karta
+class MetricsWriter {
+private:
+    string path;
+    chrono::seconds interval;
+    thread worker;
+    mutex stopMutex;
+    condition_variable stopSignal;
+    bool stopping = false;
+
+    void write() {
+        if (!writeFileAtomically(path, metrics.render())) {
+            cerr << "Klaida: nepavyko irasyti metriku i " << path << "." << endl;
+        }
+    }
+
+public:
+    MetricsWriter(string path, chrono::seconds interval) : path(std::move(path)), interval(interval) {
+        worker = thread([this] {
+            unique_lock<mutex> lock(stopMutex);
+            while (!stopSignal.wait_for(lock, this->interval, [this] { return stopping; })) write();
+        });
+    }
+
+    ~MetricsWriter() {
+        {
+            lock_guard<mutex> lock(stopMutex);
+            stopping = true;
+        }
+        stopSignal.notify_all();
+        worker.join();
+        write();
+    }
+};
+
+// Bibliotekos operacijos rezultato busena
+enum class Status {
+    Ok,
+    NotFound,        // Knyga, vartotojas ar rezervacija nerasta
+    Unavailable,     // Knyga jau rezervuota
+    AuthFailed,      // Neteisingas vardas arba slaptazodis
+    AlreadyExists,   // Vartotojas tokiu vardu jau yra
+    NotOwner,        // Rezervacija priklauso kitam vartotojui
+    InvalidRequest,  // Netinkama uzklausa
+    Queued,          // Knyga uzimta, vartotojas istatytas i laukimo eile
+    Forbidden        // Failas neleidziamas (duomenu failas ar kelias uz perdavimo katalogo)
+};
+
+// Funkcija busenai paversti trumpu tekstu (paketinio rezimo isvesciai)
+const char* statusText(Status status) {
+    switch (status) {
+        case Status::Ok: return "OK";
+        case Status::NotFound: return "NERASTA";
+        case Status::Unavailable: return "UZIMTA";
+        case Status::AuthFailed: return "PRISIJUNGIMO_KLAIDA";
+        case Status::AlreadyExists: return "JAU_YRA";
+        case Status::NotOwner: return "NE_JUSU";
+        case Status::InvalidRequest: return "NETINKAMA_UZKLAUSA";
+        case Status::Queued: return "EILEJE";
+        case Status::Forbidden: return "DRAUDZIAMA";
+    }
+    return "?";
+}
+
+// Neinteraktyvios uzklausos tipas
+enum class RequestType {
+    Register, Login, Reserve, Cancel, Available, Filter, Search, Complete, Years, Hold, Unhold, Import, Export
+};
+
+// Tipizuota uzklausa bibliotekai
+struct Request {
+    RequestType type = RequestType::Available;
+    string user;
+    string password;
+    int itemID = 0;
+    string category;
+    string words;
+    int fromYear = 0;           // Metu intervalas (years uzklausai)
+    int toYear = 0;
+    size_t offset = 0;          // Puslapiavimas: praleidziamu rezultatu skaicius
+    size_t limit = SIZE_MAX;    // ir didziausias grazinamu rezultatu skaicius
+    string path;                // Importo ar eksporto failas
+};
+
+// Uzklausos rezultatas
+struct Result {
+    Status status = Status::Ok;
+    vector<int> itemIDs;  // Rastu knygu ID (paieskos uzklausoms)
+    size_t position = 0;  // Vieta laukimo eileje (Status::Queued)
+    vector<size_t> counts;  // Importo (prideta, pasikartojo, netinkamu) ar eksporto (eiluciu) skaiciai
+};
+
+// Skaitytoju katalogo indeksai: eiluciu ID ir paieskos indeksai. Library juos skelbia kaip
+// versija (Versioned), todel uzklausos juos skaito be uzraktu. Paskelbta versija nekeiciama,
+// isskyrus kraunant, kol skaitytoju dar nera; importas pildo atsargine kopija.
+struct CatalogIndexes {
+    Column<int> ids;                // Eilute -> knygos ID
+    InvertedIndex categoryIndex;    // Normalizuotas zanras -> eilutes
+    InvertedIndex wordIndex;        // Pavadinimo ir autoriaus zodis -> eilutes
+    PrefixIndex prefixIndex;        // Pavadinimo ir autoriaus pradzia -> eilutes
+    StringDictionary categoryKeys;  // Normalizuoti zanrai; ID - grupe categoryYearIndex
+    YearIndex yearIndex;            // Metai -> eilutes
+    YearIndex categoryYearIndex;    // (Zanras, metai) -> eilutes
+
+    // Pavadinimu ir autoriu raktu zodynai turi gyventi ilgiau uz indeksus (i juos rodo prefixIndex)
+    CatalogIndexes(const StringDictionary& titleKeys, const StringDictionary& authorKeys)
+            : prefixIndex(titleKeys, authorKeys) {}
+
+    // Eilutes pridedamos didejancia tvarka; titleKey ir authorKey - raktu ID zodynuose
+    void add(uint32_t row, int id, int year, uint32_t titleKey, uint32_t authorKey,
+             const string& categoryKey, const vector<string>& words) {
+        ids.push_back(id);
+        prefixIndex.add(PrefixIndex::Title, titleKey, row);
+        prefixIndex.add(PrefixIndex::Author, authorKey, row);
+        categoryIndex.add(categoryKey, row);
+        yearIndex.add(0, year, row);
+        categoryYearIndex.add(categoryKeys.intern(categoryKey), year, row);
+        for (const auto& word : words) wordIndex.add(word, row);
+    }
+
+    // Surusiuoja naujus irasus, kad skaitytojams nereiketu
+    void ensureSorted() const {
+        prefixIndex.ensureSorted();
+        yearIndex.ensureSorted();
+        categoryYearIndex.ensureSorted();
+    }
+
+    size_t rows() const { return ids.size(); }
+
+    // Prijungia library.snap indeksus tuscioms strukturoms; eiluciu ID - katalogo stulpelis
+    void attach(const snapshot::View& file) {
+        ids.attach(file, snapshot::ItemIDs);
+        categoryIndex.attach(file, snapshot::CategoryTerms, snapshot::CategoryOffsets, snapshot::CategoryRows);
+        wordIndex.attach(file, snapshot::WordTerms, snapshot::WordOffsets, snapshot::WordRows);
+        prefixIndex.attach(file, snapshot::PrefixEntries);
+        categoryKeys.attach(file, snapshot::CategoryKeys, snapshot::CategoryKeyOrder);
+        yearIndex.attach(file, snapshot::YearEntries);
+        categoryYearIndex.attach(file, snapshot::CategoryYearEntries);
+    }
+
+    // Eiluciu ID neirasomi - jie sutampa su katalogo stulpeliu
+    void save(snapshot::Writer& out) const {
+        categoryIndex.save(out, snapshot::CategoryTerms, snapshot::CategoryOffsets, snapshot::CategoryRows);
+        wordIndex.save(out, snapshot::WordTerms, snapshot::WordOffsets, snapshot::WordRows);
+        prefixIndex.save(out, snapshot::PrefixEntries);
+        categoryKeys.save(out, snapshot::CategoryKeys, snapshot::CategoryKeyOrder);
+        yearIndex.save(out, snapshot::YearEntries);
+        categoryYearIndex.save(out, snapshot::CategoryYearEntries);
+    }
+
+    // Grazina eilutes, kuriu zanras sutampa su category (jei nurodytas) ir kuriu
+    // pavadinime ar autoriuje yra visi words zodziai
+    vector<uint32_t> search(string_view category, string_view words) const {
+        vector<RowSpan> lists;
+        RowSpan list;
+        string categoryKey = normalizeKey(category);
+        if (!categoryKey.empty()) {
+            if (!categoryIndex.find(categoryKey, list)) return {};
+            lists.push_back(list);
+        }
+        for (const auto& word : tokenize(words)) {
+            if (!wordIndex.find(word, list)) return {};
+            lists.push_back(list);
+        }
+        return intersectPostings(lists);
+    }
+
+    // Iki limit laisvu (pagal view) knygu, kuriu pavadinimas ar autorius prasideda prefix
+    // (raidziu dydis nesvarbus)
+    vector<uint32_t> completeAvailable(const CatalogSnapshot& view, string_view prefix, size_t limit) const {
+        OperationTimer timer(Operation::Complete);
+        vector<uint32_t> rows;
+        string key = normalizeKey(prefix);
+        if (key.empty() || limit == 0) return rows;
+        prefixIndex.forEachWithPrefix(key, [&](uint32_t row) {
+            // Knyga gali atitikti ir pagal pavadinima, ir pagal autoriu
+            if (view.isAvailable(row) && find(rows.begin(), rows.end(), row) == rows.end()) rows.push_back(row);
+            return rows.size() < limit;
+        });
+        return rows;
+    }
+
+    // Zanro eilutes; false, jei tokio zanro nera
+    bool findByCategory(string_view category, RowSpan& rows) const {
+        OperationTimer timer(Operation::Filter);
+        bool found = categoryIndex.find(normalizeKey(category), rows);
+        timer.setFailed(!found);
+        return found;
+    }
+
+    // Eilutes, kuriu metai tarp fromYear ir toYear (imtinai), metu tvarka; tuscias category -
+    // visi zanrai. I rows dedamas tik puslapis nuo offset (ne daugiau kaip limit eiluciu),
+    // o grazinamas visu atitikmenu skaicius.
+    size_t findByYears(string_view category, int fromYear, int toYear, size_t offset, size_t limit,
+                       vector<uint32_t>& rows) const {
+        OperationTimer timer(Operation::YearRange);
+        const YearIndex* index = &yearIndex;
+        uint32_t group = 0;
+        string categoryKey = normalizeKey(category);
+        if (!categoryKey.empty()) {
+            group = categoryKeys.find(categoryKey);
+            if (group == StringDictionary::NotFound) {
+                timer.setFailed(true);
+                return 0;
+            }
+            index = &categoryYearIndex;
+        }
+        index->forEachInRange(group, fromYear, toYear, offset, limit, [&](uint32_t row) { rows.push_back(row); });
+        return index->count(group, fromYear, toYear);
+    }
+};
+
+// Kur laikomi bibliotekos duomenys: tekstiniai failai arba dvejetainis library.snap
+enum class StorageFormat { Text, Snapshot };
+
+// Bibliotekos klase - duomenys ir operacijos be jokio cin/cout.
+// Katalogo struktura keicia tik importas, uzemes catalogMutex (juo nuo importo saugosi tik
+// rasytojai). Paieskos uzklausos nieko nerakina: jos skaito paskelbta prieinamumo versija ir
+// paskelbta indeksu versija (indexes), kuria importas pakeicia nauja. Knygos paemimas - atomine bito operacija; po jos
+// pakeitimas paskelbiamas prieinamumo versijoje kartu su tuo metu sukauptais kitu sesiju pakeitimais
+// (CatalogStore::publishRow). Skaitytojai perziuri nuoseklu vaizda ir nelaukia rasytoju.
+// Vartotojus saugo usersMutex, o rezervaciju irasus ir zurnala - reservationMutex
+// (uzrakinama tvarka catalogMutex -> usersMutex -> reservationMutex).
+class Library {
+private:
+    // Atvaizduotas library.snap: i ji rodo katalogo stulpeliai ir indeksai, todel jis
+    // atlaisvinamas paskutinis
+    MappedFile snapshotFile;
+    size_t mappedRows = 0;               // Eilutes is library.snap (ju nera itemsByID)
+    size_t snapshotRows = 0;             // Kiek eiluciu yra diske esanciame library.snap
+    CatalogStore catalog;                // Knygu duomenys stulpeliais
+    ObjectPool<CatalogItem> itemPool;    // Leidiniu vaizdai (knygos, zurnalai, DVD)
+    ObjectPool<User> userPool;
+    ObjectPool<Reservation> reservationPool;
+    ObjectPool<Hold> holdPool;
+    vector<ItemHandle> items;            // items[eilute] - knygos rankena
+
+    // Indeksai greitai paieskai, palaikomi kartu su telkiniais
+    unordered_map<int, ItemHandle> itemsByID;
+    // Normalizuoti pavadinimai ir autoriai saugomi po viena karta; i juos rodo ir prefixIndex.
+    // Leidiniai tuo paciu pavadinimu sujungti i eiluciu grandine pridejimo tvarka.
+    static constexpr uint32_t NoRow = UINT32_MAX;
+    StringDictionary titleKeys;
+    StringDictionary authorKeys;
+    Column<uint32_t> firstRowOfTitle;   // Pavadinimo rakto ID -> pirmoji eilute
+    Column<uint32_t> lastRowOfTitle;    // Pavadinimo rakto ID -> paskutine eilute
+    Column<uint32_t> nextRowOfTitle;    // Eilute -> kita eilute tuo paciu pavadinimu
+    unordered_map<string, UserHandle> usersByName;
+    vector<ReservationHandle> reservationByRow; // Aktyvi knygos rezervacija pagal eilute
+
+    // Vartotojo rezervaciju dvikryptis sarasas; nuorodos laikomos paciose rezervacijose
+    struct UserReservations {
+        ReservationHandle first;
+        ReservationHandle last;
+    };
+    vector<UserReservations> reservationsByUser; // Pagal vartotojo lizdo numeri
+
+    // Laukimo eiliu dvikryptis sarasas (knygos eile ar vartotojo laukimai)
+    struct HoldList {
+        HoldHandle first;
+        HoldHandle last;
+        size_t size = 0;
+    };
+    unordered_map<uint32_t, HoldList> holdsByRow; // Tik knygos, kurioms yra eile
+    vector<HoldList> holdsByUser;                 // Pagal vartotojo lizdo numeri
+
+    // Rezervaciju galiojimo pabaigos min-krūva (anksciausias returnBy virsuje)
+    struct ExpiryEntry {
+        time_t returnBy;
+        ReservationHandle reservation;
+        bool operator>(const ExpiryEntry& other) const { return returnBy > other.returnBy; }
+    };
+    using ExpiryQueue = priority_queue<ExpiryEntry, vector<ExpiryEntry>, greater<ExpiryEntry>>;
+    ExpiryQueue expiryQueue;
+    Versioned<CatalogIndexes> indexes;      // Skaitytoju paieskos indeksai
+
+    // Importuota eilute, kurios dar nera kurioje nors indeksu kopijoje
+    struct PendingRow {
+        uint32_t row;
+        int id;
+        int year;
+        uint32_t titleKey, authorKey;     // ID titleKeys ir authorKeys zodynuose
+        string categoryKey;
+        vector<string> words;
+    };
+    // Importo metu: antroji indeksu kopija, kuriai truksta laggingRows, ir dar
+    // nepaskelbtos eilutes (pendingRows)
+    unique_ptr<CatalogIndexes> spareIndexes;
+    vector<PendingRow> laggingRows, pendingRows;
+    bool deferIndexing = false;  // addItem eilutes deda i pendingRows (importo metu)
+
+    ReservationJournal journal;
+    JournalConfig journalConfig;
+    bool persistent = true;   // Ar pakeitimai rasomi i failus
+    StorageFormat storageFormat = StorageFormat::Text;
+
+    mutable shared_mutex catalogMutex; // Katalogo stulpeliai ir itemPool rasytojams (keicia importas)
+    mutable shared_mutex usersMutex;   // userPool ir usersByName
+    mutable mutex reservationMutex;    // reservationPool, reservationByRow, reservationsByUser, laukimo eiles
+
+    // Foninis irasymas: operacijos tik pazymi pakeitimus, o persistenceThread juos sugrupuoja
+    // ir iraso i diska. Uzraktu tvarka: usersMutex -> reservationMutex -> persistMutex.
+    mutex persistMutex;
+    condition_variable persistWork;     // Atsirado darbo (arba stabdoma)
+    condition_variable persistDone;     // Pakeitimai irasyti (flush() laukia)
+    string pendingRecords;              // Dar neirasytos zurnalo eilutes
+    size_t pendingCount = 0;
+    bool usersDirty = false;            // Reikia perrasyti users.txt
+    bool compactionRequested = false;   // Reikia suspausti zurnala
+    bool stopping = false;
+    uint64_t submitted = 0;             // Pazymetu pakeitimu skaicius
+    uint64_t persisted = 0;             // Kiek is ju jau irasyta
+    thread persistenceThread;
+
+    // Normalizuoti knygos indeksu raktai; gali buti apskaiciuoti is anksto kitoje gijoje
+    struct ItemKeys {
+        string title;
+        string author;
+        string category;
+        vector<string> words;
+    };
+
+    static ItemKeys itemKeys(string_view title, string_view author, string_view category) {
+        return {normalizeKey(title), normalizeKey(author), normalizeKey(category),
+                tokenize(string(title) + " " + string(author))};
+    }
+
+    // books.txt ar importo eilutes laukai
+    struct ParsedBook {
+        string_view title, author, category;
+        int year = 0;
+        ItemKind kind = ItemKind::Book;
+        int detail = 0;
+        ItemKeys keys;
+    };
+
+    // Neprivalomi laukai: rusis (knyga, zurnalas, dvd) ir zurnalo numeris ar DVD trukme
+    static void parseBook(const Record& rec, ParsedBook& book, string& error) {
+        if (rec.count < 4 || rec.count > 6) {
+            error = "tiketini 4-6 laukai, rasta " + to_string(rec.count);
+        } else if (!parseInt(rec.fields[2], book.year)) {
+            error = "netinkami metai '" + string(rec.fields[2]) + "'";
+        } else if (rec.count >= 5 && !parseItemKind(rec.fields[4], book.kind)) {
+            error = "netinkama rusis '" + string(rec.fields[4]) + "'";
+        } else if ((book.kind != ItemKind::Book) != (rec.count == 6)) {
+            error = book.kind == ItemKind::Book ? "knygai papildomas laukas nereikalingas"
+                                                : "truksta numerio ar trukmes";
+        } else if (rec.count == 6 && (!parseInt(rec.fields[5], book.detail) || book.detail <= 0)) {
+            error = "netinkamas numeris ar trukme '" + string(rec.fields[5]) + "'";
+        } else if (!isStorableField(rec.fields[0]) || !isStorableField(rec.fields[1]) ||
+                   !isStorableField(rec.fields[3])) {
+            error = "lauke yra '|' ar eilutes pabaiga";
+        } else {
+            book.title = rec.fields[0];
+            book.author = rec.fields[1];
+            book.category = rec.fields[3];
+            book.keys = itemKeys(book.title, book.author, book.category);
+        }
+    }
+
+    ItemHandle addItem(string_view title, string_view author, int year, string_view category,
+                       ItemKind kind = ItemKind::Book, int detail = 0) {
+        return addItem(title, author, year, category, kind, detail, itemKeys(title, author, category));
+    }
+
+    // Rusies leidinio vaizdas; fields - naujos eilutes laukai arba jau esancios eilutes numeris
+    template <typename... Fields>
+    ItemHandle createItem(ItemKind kind, int detail, const Fields&... fields) {
+        switch (kind) {
+            case ItemKind::Magazine:
+                return itemPool.create(in_place_type<Magazine>, catalog, fields..., detail);
+            case ItemKind::DVD:
+                return itemPool.create(in_place_type<DVD>, catalog, fields..., detail);
+            default:
+                return itemPool.create(in_place_type<Book>, catalog, fields...);
+        }
+    }
+
+    ItemHandle addItem(string_view title, string_view author, int year, string_view category, ItemKind kind,
+                       int detail, ItemKeys keys) {
+        ItemHandle handle = createItem(kind, detail, title, author, year, category);
+        const LibraryItem* item = itemOf(handle);
+        items.push_back(handle); // Eilutes numeris sutampa su pozicija items
+        reservationByRow.emplace_back();
+        itemsByID[item->getID()] = handle;
+        uint32_t row = static_cast<uint32_t>(item->getRow());
+        uint32_t titleID = titleKeys.intern(keys.title);
+        if (titleID == firstRowOfTitle.size()) {
+            firstRowOfTitle.push_back(NoRow);
+            lastRowOfTitle.push_back(NoRow);
+        }
+        nextRowOfTitle.push_back(NoRow);
+        if (firstRowOfTitle[titleID] == NoRow) firstRowOfTitle.set(titleID, row);
+        else nextRowOfTitle.set(lastRowOfTitle[titleID], row);
+        lastRowOfTitle.set(titleID, row);
+        uint32_t authorID = authorKeys.intern(keys.author);
+        if (deferIndexing) {
+            pendingRows.push_back({row, item->getID(), year, titleID, authorID, std::move(keys.category),
+                                   std::move(keys.words)});
+        } else {
+            // Kraunant ir ruosiant kataloga skaitytoju dar nera, todel pildoma paskelbta versija
+            indexes.current()->add(row, item->getID(), year, titleID, authorID, keys.category, keys.words);
+        }
+        return handle;
+    }
+
+    // Paskelbia indeksu versija su visomis importuotomis eilutemis, o po jos - prieinamumo
+    // versija (skaitytojas, paemes prieinamumo vaizda, indeksuose ras visas jo eilutes).
+    // Pildoma atsargine kopija; exchange grazina ankstesne versija, kai jos nebeskaito niekas.
+    void publishIndexes() {
+        auto addRows = [&](const vector<PendingRow>& rows) {
+            for (const PendingRow& p : rows) {
+                spareIndexes->add(p.row, p.id, p.year, p.titleKey, p.authorKey, p.categoryKey, p.words);
+            }
+        };
+        if (spareIndexes) addRows(laggingRows);
+        else spareIndexes = make_unique<CatalogIndexes>(*indexes.current());
+        addRows(pendingRows);
+        spareIndexes->ensureSorted();
+        spareIndexes = indexes.exchange(std::move(spareIndexes));
+        laggingRows = std::move(pendingRows);
+        pendingRows.clear();
+        catalog.publish();
+    }
+
+    // Bendra leidinio dalis pagal rankena (nullptr, jei rankena negalioja)
+    LibraryItem* itemOf(ItemHandle handle) {
+        CatalogItem* item = itemPool.get(handle);
+        return item ? &asItem(*item) : nullptr;
+    }
+
+    const LibraryItem* itemOf(ItemHandle handle) const {
+        const CatalogItem* item = itemPool.get(handle);
+        return item ? &asItem(*item) : nullptr;
+    }
+
+    // Grazina negaliojancia rankena, jei vartotojas tokiu vardu jau egzistuoja
+    UserHandle addUser(string name, string password) {
+        if (usersByName.count(name)) return UserHandle();
+        UserHandle handle = userPool.create(name, std::move(password));
+        usersByName.emplace(std::move(name), handle);
+        return handle;
+    }
+
+    // Randa vartotoja; jei jo nera - sukuria laikina (be slaptazodzio)
+    UserHandle findOrAddUser(string_view name) {
+        UserHandle handle = findUser(name);
+        return handle.valid() ? handle : addUser(string(name), "");
+    }
+
+    ReservationHandle addReservation(UserHandle user, ItemHandle item, time_t reservedAt, time_t returnBy) {
+        ReservationHandle handle = reservationPool.create(user, item, reservedAt, returnBy);
+        linkReservation(handle);
+        return handle;
+    }
+
+    // Naujai sukurta rezervacija itraukiama i knygos, vartotojo ir galiojimo indeksus
+    void linkReservation(ReservationHandle handle) {
+        Reservation* res = reservationPool.get(handle);
+        reservationByRow[itemOf(res->getItem())->getRow()] = handle;
+        size_t slot = res->getUser().index;
+        if (slot >= reservationsByUser.size()) reservationsByUser.resize(slot + 1);
+        UserReservations& list = reservationsByUser[slot];
+        res->setPreviousOfUser(list.last);
+        res->setNextOfUser(ReservationHandle());
+        if (Reservation* last = reservationPool.get(list.last)) last->setNextOfUser(handle);
+        else list.first = handle;
+        list.last = handle;
+        scheduleExpiry(handle);
+    }
+
+    // Rezervacija ismetama is vartotojo saraso per O(1)
+    void unlinkFromUser(const Reservation& res) {
+        UserReservations& list = reservationsByUser[res.getUser().index];
+        Reservation* previous = reservationPool.get(res.getPreviousOfUser());
+        Reservation* next = reservationPool.get(res.getNextOfUser());
+        if (previous) previous->setNextOfUser(res.getNextOfUser());
+        else list.first = res.getNextOfUser();
+        if (next) next->setPreviousOfUser(res.getPreviousOfUser());
+        else list.last = res.getPreviousOfUser();
+    }
+
+    // Rezervacija idedama i galiojimo pabaigos krūva. Atsauktos rezervacijos is krūvos
+    // nesalinamos (tikrinama isimant); kai pasenusiu irasu tampa daugiau nei gyvu, krūva perstatoma.
+    void scheduleExpiry(ReservationHandle handle) {
+        expiryQueue.push({reservationPool.get(handle)->getReturnBy(), handle});
+        if (expiryQueue.size() > 2 * reservationPool.size() + 1024) {
+            vector<ExpiryEntry> live;
+            live.reserve(reservationPool.size());
+            reservationPool.forEach([&](ReservationHandle h, const Reservation& res) {
+                live.push_back({res.getReturnBy(), h});
+            });
+            expiryQueue = ExpiryQueue(greater<ExpiryEntry>(), std::move(live));
+        }
+    }
+
+    // Atsaukia rezervacija: lizdas grazinamas telkiniui, o knyga tampa laisva tik po to,
+    // kad kita sesija ja paemusi nerastu senos rezervacijos. Jei promote ir knygos laukia
+    // eile, knyga lieka uzimta ir per O(1) atiduodama pirmajam eileje (zurnale - '<' ir '+').
+    void removeReservation(ReservationHandle handle, bool promote = false) {
+        Reservation* res = reservationPool.get(handle);
+        if (!res) return;
+        LibraryItem* item = itemOf(res->getItem());
+        if (item) reservationByRow[item->getRow()] = ReservationHandle();
+        unlinkFromUser(*res);
+        reservationPool.destroy(handle);
+        if (!item) return;
+        auto queue = promote ? holdsByRow.find(static_cast<uint32_t>(item->getRow())) : holdsByRow.end();
+        if (queue == holdsByRow.end()) {
+            item->returnItem();
+            return;
+        }
+        const Hold* head = holdPool.get(queue->second.first);
+        UserHandle next = head->getUser();
+        ItemHandle itemHandle = head->getItem();
+        journalHoldRemoval(head);
+        removeHold(queue->second.first);
+        grantReservation(next, itemHandle);
+    }
+
+    // Sukuria rezervacija jau paimtai knygai; kvieciama laikant reservationMutex
+    void grantReservation(UserHandle user, ItemHandle item) {
+        ReservationHandle handle = reservationPool.create(user, item);
+        linkReservation(handle);
+        journalReservation(reservationPool.get(handle)); // Įrašo rezervaciją į žurnalą
+    }
+
+    // Laukimo irasas pridedamas knygos eiles ir vartotojo saraso gale
+    HoldHandle addHold(UserHandle user, ItemHandle item, time_t requestedAt) {
+        HoldHandle handle = holdPool.create(user, item, requestedAt);
+        Hold* hold = holdPool.get(handle);
+        HoldList& queue = holdsByRow[static_cast<uint32_t>(itemOf(item)->getRow())];
+        hold->setPreviousInQueue(queue.last);
+        if (Hold* last = holdPool.get(queue.last)) last->setNextInQueue(handle);
+        else queue.first = handle;
+        queue.last = handle;
+        ++queue.size;
+        if (user.index >= holdsByUser.size()) holdsByUser.resize(user.index + 1);
+        HoldList& mine = holdsByUser[user.index];
+        hold->setPreviousOfUser(mine.last);
+        if (Hold* last = holdPool.get(mine.last)) last->setNextOfUser(handle);
+        else mine.first = handle;
+        mine.last = handle;
+        ++mine.size;
+        return handle;
+    }
+
+    // Laukimo irasas ismetamas is abieju sarasu per O(1)
+    void removeHold(HoldHandle handle) {
+        const Hold* hold = holdPool.get(handle);
+        if (!hold) return;
+        auto queue = holdsByRow.find(static_cast<uint32_t>(itemOf(hold->getItem())->getRow()));
+        if (Hold* previous = holdPool.get(hold->getPreviousInQueue())) previous->setNextInQueue(hold->getNextInQueue());
+        else queue->second.first = hold->getNextInQueue();
+        if (Hold* next = holdPool.get(hold->getNextInQueue())) next->setPreviousInQueue(hold->getPreviousInQueue());
+        else queue->second.last = hold->getPreviousInQueue();
+        if (--queue->second.size == 0) holdsByRow.erase(queue);
+        HoldList& mine = holdsByUser[hold->getUser().index];
+        if (Hold* previous = holdPool.get(hold->getPreviousOfUser())) previous->setNextOfUser(hold->getNextOfUser());
+        else mine.first = hold->getNextOfUser();
+        if (Hold* next = holdPool.get(hold->getNextOfUser())) next->setPreviousOfUser(hold->getPreviousOfUser());
+        else mine.last = hold->getPreviousOfUser();
+        --mine.size;
+        holdPool.destroy(handle);
+    }
+
+    // Vartotojo laukimas konkreciai knygai; perziurimas tik to vartotojo sarasas
+    HoldHandle findHold(UserHandle user, ItemHandle item) const {
+        if (user.index >= holdsByUser.size()) return HoldHandle();
+        for (HoldHandle handle = holdsByUser[user.index].first; handle.valid();) {
+            const Hold* hold = holdPool.get(handle);
+            if (!hold) break;
+            if (hold->getUser() == user && hold->getItem() == item) return handle;
+            handle = hold->getNextOfUser();
+        }
+        return HoldHandle();
+    }
+
+    // Vieta knygos eileje (1 - pirmas)
+    size_t positionInQueue(HoldHandle handle) const {
+        size_t position = 0;
+        for (; handle.valid(); handle = holdPool.get(handle)->getPreviousInQueue()) ++position;
+        return position;
+    }
+
+    ReservationHandle findReservation(ItemHandle item) const {
+        const LibraryItem* book = itemOf(item);
+        return book ? reservationByRow[book->getRow()] : ReservationHandle();
+    }
+
+    // Pavadinimas ir autorius leidinio neapibrezia (to paties zurnalo numeriai, DVD),
+    // todel irasu gale pridedama rusis ir papildomas laukas
+    void appendIdentity(string& record, ItemHandle handle) const {
+        const CatalogItem& item = *itemPool.get(handle);
+        record += '|';
+        record += itemKindName(kindOf(item));
+        record += '|';
+        record += to_string(detailOf(item));
+    }
+
+    void journalReservation(const Reservation* res) {
+        const User* user = userPool.get(res->getUser());
+        const LibraryItem* item = itemOf(res->getItem());
+        string record;
+        appendFields(record, {"+", user->getName(), item->getTitle(), item->getAuthor(), item->getCategory(),
+                              res->getReservationDate(), res->getReturnDate()});
+        appendIdentity(record, res->getItem());
+        submitRecord(record);
+    }
+
+    void journalCancellation(const Reservation* res) {
+        string record;
+        const LibraryItem* item = itemOf(res->getItem());
+        appendFields(record, {"-", userPool.get(res->getUser())->getName(), item->getTitle(),
+                              res->getReservationDate(), item->getAuthor()});
+        appendIdentity(record, res->getItem());
+        submitRecord(record);
+    }
+
+    // Importuotas leidinys books.txt formatu; library.snap ji gaus suspaudziant zurnala
+    void journalItem(ItemHandle handle) {
+        string record = "i|";
+        appendItemRecord(record, itemOf(handle)->getRow(), false);
+        record.pop_back(); // '\n' prideda submitRecord
+        submitRecord(record);
+    }
+
+    void journalHold(const Hold* hold) {
+        const LibraryItem* item = itemOf(hold->getItem());
+        string record;
+        appendFields(record, {">", userPool.get(hold->getUser())->getName(), item->getTitle(), item->getAuthor(),
+                              formatTime(hold->getRequestedAt())});
+        appendIdentity(record, hold->getItem());
+        submitRecord(record);
+    }
+
+    void journalHoldRemoval(const Hold* hold) {
+        const LibraryItem* item = itemOf(hold->getItem());
+        string record;
+        appendFields(record, {"<", userPool.get(hold->getUser())->getName(), item->getTitle(), item->getAuthor()});
+        appendIdentity(record, hold->getItem());
+        submitRecord(record);
+    }
+
+    // Zurnalo irasas perduodamas fonio gijai; kvieciama laikant reservationMutex (vartotojo
+    // irasas - usersMutex)
+    void submitRecord(const string& record) {
+        if (!persistent) return;
+        lock_guard<mutex> lock(persistMutex);
+        pendingRecords += record;
+        pendingRecords += '\n';
+        ++pendingCount;
+        ++submitted;
+        persistWork.notify_one();
+    }
+
+    void markDirty(bool users, bool compaction) {
+        if (!persistent) return;
+        lock_guard<mutex> lock(persistMutex);
+        usersDirty = usersDirty || users;
+        compactionRequested = compactionRequested || compaction;
+        ++submitted;
+        persistWork.notify_one();
+    }
+
+    // Fonio gija: paima visus per ta laika susikaupusius pakeitimus ir iraso juos kartu
+    void persistenceLoop() {
+        unique_lock<mutex> lock(persistMutex);
+        while (true) {
+            persistWork.wait(lock, [&] { return stopping || persisted != submitted; });
+            if (persisted == submitted) break; // Stabdoma ir viskas irasyta
+            uint64_t target = submitted;
+            string records;
+            records.swap(pendingRecords);
+            size_t count = pendingCount;
+            pendingCount = 0;
+            bool users = usersDirty, compaction = compactionRequested;
+            usersDirty = compactionRequested = false;
+            lock.unlock();
+            persistChanges(records, count, users, compaction);
+            lock.lock();
+            persisted = target;
+            persistDone.notify_all();
+        }
+    }
+
+    void persistChanges(const string& records, size_t count, bool users, bool compaction) {
+        if (count > 0 && !journal.append(records, count)) {
+            cerr << "Klaida: nepavyko irasyti i zurnala " << journal.getPath() << "." << endl;
+        }
+        if (compaction || journal.needsCompaction()) writeReservationsFile();
+        if (users) writeUsersFile();
+    }
+
+    // Pritaiko viena zurnalo irasa. Irasai idempotentiski: jei suspaudimas nutrauktas
+    // po reservations.txt perrasymo, bet pries zurnalo isvalyma, pakartotinis
+    // pritaikymas busenos nekeicia.
+    void replayJournalRecord(const Record& rec) {
+        const string_view* f = rec.fields;
+        if (f[0] == "+" && (rec.count == 7 || rec.count == 9)) {
+            ItemHandle itemHandle = findRecordItem(rec, 2, 3, 7);
+            LibraryItem* item = itemOf(itemHandle);
+            time_t reservedAt, returnBy;
+            if (!parseTime(f[5], reservedAt) || !parseTime(f[6], returnBy)) {
+                reportBadLine("reservations.journal", rec.lineNumber, "netinkama data");
+                return;
+            }
+            if (!item || !item->borrowItem()) return; // Jau rezervuota (ar ta pati rezervacija)
+            UserHandle user = findOrAddUser(f[1]);
+            addReservation(user, itemHandle, reservedAt, returnBy);
+        } else if (f[0] == "-" && (rec.count == 4 || rec.count == 7)) {
+            // Senuose atsaukimuose autoriaus nera: tinka to pavadinimo leidinys su sio vartotojo ir laiko rezervacija
+            time_t reservedAt;
+            if (!parseTime(f[3], reservedAt)) return;
+            auto cancel = [&](uint32_t row) {
+                ReservationHandle handle = reservationByRow[row];
+                const Reservation* res = reservationPool.get(handle);
+                if (!res || userPool.get(res->getUser())->getName() != f[1] || res->getReservedAt() != reservedAt) {
+                    return false;
+                }
+                removeReservation(handle);
+                return true;
+            };
+            if (rec.count == 7) {
+                if (const LibraryItem* item = itemOf(findRecordItem(rec, 2, 4, 5))) cancel(item->getRow());
+                return;
+            }
+            for (uint32_t row = firstRowWithTitle(f[2]); row != NoRow && !cancel(row); row = nextRowOfTitle[row]) {}
+        } else if (f[0] == ">" && (rec.count == 5 || rec.count == 7)) {
+            ItemHandle item = findRecordItem(rec, 2, 3, 5);
+            time_t requestedAt;
+            if (!itemOf(item) || !parseTime(f[4], requestedAt)) return;
+            UserHandle user = findOrAddUser(f[1]);
+            if (!findHold(user, item).valid()) addHold(user, item, requestedAt);
+        } else if (f[0] == "<" && (rec.count == 4 || rec.count == 6)) {
+            removeHold(findHold(findUser(f[1]), findRecordItem(rec, 2, 3, 4)));
+        } else if (f[0] == "i" && (rec.count == 5 || rec.count == 7)) {
+            // Leidinio laukai - kaip books.txt eiluteje; jau esantis (suspaudimas nutrauktas) praleidziamas
+            Record item;
+            item.count = rec.count - 1;
+            item.lineNumber = rec.lineNumber;
+            copy(f + 1, f + rec.count, item.fields);
+            ParsedBook book;
+            string error;
+            parseBook(item, book, error);
+            if (!error.empty()) {
+                reportBadLine("reservations.journal", rec.lineNumber, error);
+            } else if (!containsItem(book)) {
+                addItem(book.title, book.author, book.year, book.category, book.kind, book.detail,
+                        std::move(book.keys));
+            }
+        } else if (f[0] == "u" && rec.count == 3) {
+            // Senesnio zurnalo registracija (jau esantis vartotojas nekeiciamas); zurnala suspaudus
+            // ji liktu tik users.txt, todel jis perrasomas
+            if (addUser(string(f[1]), string(f[2])).valid()) markDirty(true, false);
+        } else {
+            reportBadLine("reservations.journal", rec.lineNumber, "netinkamas zurnalo irasas");
+        }
+    }
+
+    // library.snap eilutes i itemsByID nededamos: ju ID didejantys, todel randami dvejetaine paieska
+    ItemHandle findItemByID(int id) const {
+        auto it = itemsByID.find(id);
+        if (it != itemsByID.end()) return it->second;
+        size_t row = catalog.findRow(id, mappedRows);
+        return row < mappedRows ? items[row] : ItemHandle();
+    }
+
+    // Jei yra kelios knygos tuo paciu pavadinimu, grazinama pirmoji
+    // Pirmoji eilute su tokiu pavadinimu (NoRow, jei nera)
+    uint32_t firstRowWithTitle(string_view title) const {
+        uint32_t titleID = titleKeys.find(normalizeKey(title));
+        return titleID != StringDictionary::NotFound ? firstRowOfTitle[titleID] : NoRow;
+    }
+
+    ItemHandle findItemByTitle(string_view title) const {
+        uint32_t row = firstRowWithTitle(title);
+        return row != NoRow ? items[row] : ItemHandle();
+    }
+
+    // Keli leidiniai tuo paciu pavadinimu atskiriami pagal autoriu: autoriaus kodas randamas
+    // viena karta, o eilutes lyginamos pagal koda
+    ItemHandle findItemByTitle(string_view title, string_view author) const {
+        uint32_t row = firstRowWithTitle(title);
+        if (row == NoRow) return ItemHandle();
+        if (nextRowOfTitle[row] != NoRow) {
+            uint32_t code = catalog.findAuthorCode(author);
+            for (uint32_t r = row; r != NoRow; r = nextRowOfTitle[r]) {
+                if (catalog.getAuthorCode(r) == code) return items[r];
+            }
+        }
+        return items[row];
+    }
+
+    // Iraso leidinys pagal pavadinimo, autoriaus, rusies ir papildomo (kind + 1) lauku numerius.
+    // Senuose irasuose rusies nera - tada tinka bet kuris to pavadinimo ir autoriaus leidinys.
+    ItemHandle findRecordItem(const Record& rec, size_t title, size_t author, size_t kind) const {
+        const string_view* f = rec.fields;
+        if (rec.count <= kind) return findItemByTitle(f[title], f[author]);
+        ItemKind itemKind;
+        int detail;
+        if (rec.count != kind + 2 || !parseItemKind(f[kind], itemKind) || !parseInt(f[kind + 1], detail)) {
+            return ItemHandle();
+        }
+        uint32_t code = catalog.findAuthorCode(f[author]);
+        for (uint32_t row = firstRowWithTitle(f[title]); row != NoRow; row = nextRowOfTitle[row]) {
+            const CatalogItem& item = *itemPool.get(items[row]);
+            if (catalog.getAuthorCode(row) == code && kindOf(item) == itemKind && detailOf(item) == detail) {
+                return items[row];
+            }
+        }
+        return ItemHandle();
+    }
+
+    UserHandle findUser(string_view name) const {
+        auto it = usersByName.find(string(name));
+        return it != usersByName.end() ? it->second : UserHandle();
+    }
+
+    UserHandle findUserLocked(string_view name) const {
+        shared_lock<shared_mutex> lock(usersMutex);
+        return findUser(name);
+    }
+
+    static constexpr const char* SnapshotPath = "library.snap";
+    static constexpr const char* WaitlistsPath = "waitlists.txt"; // Abiem formatais - tekstinis
+
+    // Leidinio eilute books.txt arba CSV formatu. Knygoms papildomi laukai nerasomi -
+    // failas lieka suderinamas su senu formatu.
+    // books.txt formatu eilute neprirasoma (grazinama false), jei lauke yra skirtukas
+    bool appendItemRecord(string& text, size_t row, bool csv) const {
+        const CatalogItem& item = *itemPool.get(items[row]);
+        string year = to_string(catalog.getYear(row));
+        bool book = kindOf(item) == ItemKind::Book;
+        string detail = book ? string() : to_string(detailOf(item));
+        if (csv) {
+            size_t fields = book ? 4 : 6;
+            string_view values[] = {catalog.getTitle(row), catalog.getAuthor(row), year, catalog.getCategory(row),
+                                    itemKindName(kindOf(item)), detail};
+            for (size_t i = 0; i < fields; ++i) {
+                if (i > 0) text += ',';
+                appendCsvField(text, values[i]);
+            }
+        } else {
+            for (string_view field : {catalog.getTitle(row), catalog.getAuthor(row), catalog.getCategory(row)}) {
+                if (!isStorableField(field)) return false;
+            }
+            appendFields(text, {catalog.getTitle(row), catalog.getAuthor(row), year, catalog.getCategory(row)});
+            if (!book) text += string("|") + itemKindName(kindOf(item)) + "|" + detail;
+        }
+        text += '\n';
+        return true;
+    }
+
+    string booksText() const {
+        string text;
+        catalog.forEachRow([&](size_t row) { appendItemRecord(text, row, false); });
+        return text;
+    }
+
+    // Ar kataloge jau yra toks leidinys: tas pats pavadinimas ir autorius (raidziu dydis
+    // nesvarbus), rusis ir papildomas laukas - kitas zurnalo numeris yra naujas leidinys
+    bool containsItem(const ParsedBook& book) const {
+        uint32_t titleID = titleKeys.find(book.keys.title);
+        if (titleID == StringDictionary::NotFound) return false;
+        for (uint32_t row = firstRowOfTitle[titleID]; row != NoRow; row = nextRowOfTitle[row]) {
+            const CatalogItem& item = *itemPool.get(items[row]);
+            if (kindOf(item) == book.kind && detailOf(item) == book.detail &&
+                normalizeKey(catalog.getAuthor(row)) == book.keys.author) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Prideda dar nesamas bloko knygas failo tvarka. Uzrakinamas tik suliejimas: blokas
+    // isnagrinetas anksciau. Naujos eilutes prirasomos prie books.txt (dirbant su library.snap -
+    // i zurnala 'i' irasais) dar laikant uzrakta, todel zurnale rezervacija niekada nenurodo
+    // knygos, kurios po gedimo nebutu.
+    void mergeImported(vector<ParsedBook>& books, int booksFd, size_t& added, size_t& duplicates,
+                       size_t& rejected) {
+        unique_lock<shared_mutex> catalogLock(catalogMutex);
+        lock_guard<mutex> lock(reservationMutex);
+        string appended;
+        for (ParsedBook& book : books) {
+            // Tokio leidinio nebutu galima irasyti i books.txt ir rezervaciju failus
+            if (!isStorableField(book.title) || !isStorableField(book.author) || !isStorableField(book.category)) {
+                ++rejected;
+                continue;
+            }
+            if (containsItem(book)) {
+                ++duplicates;
+                continue;
+            }
+            deferIndexing = true;
+            ItemHandle handle = addItem(book.title, book.author, book.year, book.category, book.kind,
+                                        book.detail, std::move(book.keys));
+            deferIndexing = false;
+            if (booksFd >= 0) appendItemRecord(appended, itemOf(handle)->getRow(), false);
+            else if (storageFormat == StorageFormat::Snapshot) journalItem(handle);
+            ++added;
+        }
+        if (booksFd >= 0 && !writeFully(booksFd, appended)) {
+            cerr << "Klaida: nepavyko prirasyti importuotu knygu prie books.txt." << endl;
+        }
+        // Kiekviena versija kainuoja tiek, kiek katalogas didelis, todel skelbiama, kai laukia
+        // bent ketvirtadalis jau paskelbtu eiluciu; likusios - importo pabaigoje
+        if (!pendingRows.empty() && pendingRows.size() * 4 >= indexes.current()->rows()) publishIndexes();
+    }
+
+    string usersText() const {
+        string text;
+        userPool.forEach([&](UserHandle, const User& user) {
+            text += user.getName() + " " + user.getPassword() + "\n";
+        });
+        return text;
+    }
+
+    string reservationsText() const {
+        string text;
+        reservationPool.forEach([&](ReservationHandle, const Reservation& res) {
+            const LibraryItem* item = itemOf(res.getItem());
+            appendFields(text, {userPool.get(res.getUser())->getName(), item->getTitle(), item->getAuthor(),
+                                item->getCategory(), item->checkAvailability() ? "1" : "0",
+                                res.getReservationDate(), res.getReturnDate()});
+            appendIdentity(text, res.getItem());
+            text += '\n';
+        });
+        return text;
+    }
+
+    // Laukimo eiles knygu tvarka, kiekviena - nuo pirmojo laukiancio; kvieciama laikant abu uzraktus
+    string waitlistsText() const {
+        vector<uint32_t> rows;
+        rows.reserve(holdsByRow.size());
+        for (const auto& entry : holdsByRow) rows.push_back(entry.first);
+        sort(rows.begin(), rows.end());
+        string text;
+        for (uint32_t row : rows) {
+            for (HoldHandle handle = holdsByRow.at(row).first; handle.valid();) {
+                const Hold* hold = holdPool.get(handle);
+                const LibraryItem* item = itemOf(hold->getItem());
+                appendFields(text, {userPool.get(hold->getUser())->getName(), item->getTitle(), item->getAuthor(),
+                                    formatTime(hold->getRequestedAt())});
+                appendIdentity(text, hold->getItem());
+                text += '\n';
+                handle = hold->getNextInQueue();
+            }
+        }
+        return text;
+    }
+
+    // Katalogo ir indeksu dvejetainis vaizdas (tuscias, jei failas butu per didelis). Kvieciama
+    // laikant catalogMutex (pakanka bendro), kai nera nepaskelbtu importo eiluciu - tada
+    // paskelbti indeksai aprepia visa kataloga.
+    string buildSnapshot() const {
+        snapshot::Writer out;
+        catalog.save(out);
+        vector<snapshot::Kind> kinds;
+        kinds.reserve(catalog.size());
+        catalog.forEachRow([&](size_t row) {
+            const CatalogItem& item = *itemPool.get(items[row]);
+            kinds.push_back({static_cast<uint32_t>(kindOf(item)), detailOf(item)});
+        });
+        out.put(snapshot::Kinds, kinds);
+        nextRowOfTitle.save(out, snapshot::NextRowOfTitle);
+        authorKeys.save(out, snapshot::AuthorKeys, snapshot::AuthorKeyOrder);
+        titleKeys.save(out, snapshot::TitleKeys, snapshot::TitleKeyOrder);
+        firstRowOfTitle.save(out, snapshot::FirstRowOfTitle);
+        lastRowOfTitle.save(out, snapshot::LastRowOfTitle);
+        indexes.current()->save(out);
+        string file = out.build(catalog.size());
+        if (file.empty()) cerr << "Klaida: " << SnapshotPath << " eiluciu blokas virsija 4 GiB." << endl;
+        return file;
+    }
+
+    // Prijungia library.snap prie tuscios bibliotekos. Stulpeliai, zodynai ir indeksai
+    // naudojami tiesiai is atvaizduoto failo (nekuriami ir nerusiuojami); sukuriami tik
+    // leidiniu vaizdai. Failas patikrinamas visas pries keiciant busena, todel klaidos atveju
+    // biblioteka lieka tuscia.
+    bool loadSnapshot(const string& path) {
+        snapshot::View view;
+        const char* error = snapshotFile.open(path, false) ? snapshot::open(snapshotFile.view(), view)
+                                                           : "nepavyko atidaryti";
+        if (error) {
+            cerr << "Klaida: " << path << " netinkamas (" << error << "), naudojami tekstiniai failai." << endl;
+            snapshotFile.close();
+            return false;
+        }
+        catalog.attach(view);
+        titleKeys.attach(view, snapshot::TitleKeys, snapshot::TitleKeyOrder);
+        authorKeys.attach(view, snapshot::AuthorKeys, snapshot::AuthorKeyOrder);
+        firstRowOfTitle.attach(view, snapshot::FirstRowOfTitle);
+        lastRowOfTitle.attach(view, snapshot::LastRowOfTitle);
+        nextRowOfTitle.attach(view, snapshot::NextRowOfTitle);
+        indexes.current()->attach(view);
+        size_t rows = catalog.size();
+        const snapshot::Kind* kinds = view.items<snapshot::Kind>(snapshot::Kinds);
+        items.reserve(rows);
+        for (size_t row = 0; row < rows; ++row) {
+            items.push_back(createItem(static_cast<ItemKind>(kinds[row].kind), kinds[row].detail, row));
+        }
+        reservationByRow.resize(rows);
+        mappedRows = snapshotRows = rows;
+        return true;
+    }
+
+    // Suspaudzia zurnala: reservations.txt ir waitlists.txt perrasomi atomiskai (laikinas failas
+    // + rename), po to zurnalas isvalomas. Jei nuo paskutinio suspaudimo niekas nepasikeite,
+    // failai nelieciami. library.snap perrasomas tik kai kataloge atsirado eiluciu (importas),
+    // o kol importuotos eilutes dar neindeksuotos, suspaudimas atidedamas - ji pakartos importo
+    // pabaiga. Turinys sudaromas laikant uzraktus, o i diska rasoma juos paleidus.
+    // Kvieciama tik is fonio gijos.
+    void writeReservationsFile() {
+        bool snapshotMode = storageFormat == StorageFormat::Snapshot;
+        // Katalogas rakinamas pirmas: kol sudaromas library.snap, importas eiluciu neprideda
+        shared_lock<shared_mutex> catalogLock(catalogMutex, defer_lock);
+        if (snapshotMode) {
+            catalogLock.lock();
+            if (!pendingRows.empty()) return;
+        }
+        size_t rows = catalog.size();
+        bool catalogChanged = snapshotMode && rows != snapshotRows;
+        string contents, waitlists;
+        string records;  // Dar neirasyti zurnalo irasai, jau atspindeti naujuose failuose
+        size_t count;
+        {
+            shared_lock<shared_mutex> usersLock(usersMutex);
+            lock_guard<mutex> lock(reservationMutex);
+            lock_guard<mutex> persistLock(persistMutex);
+            if (pendingCount == 0 && journal.empty() && !catalogChanged) return;
+            contents = reservationsText();
+            waitlists = waitlistsText();
+            records.swap(pendingRecords);
+            count = pendingCount;
+            pendingCount = 0;
+        }
+        OperationTimer timer(Operation::SaveReservations);
+        bool ok = true;
+        if (catalogChanged) {
+            OperationTimer snapshotTimer(Operation::SaveSnapshot);
+            string image = buildSnapshot();
+            catalogLock.unlock();
+            ok = !image.empty() && writeFileAtomically(SnapshotPath, image);
+            snapshotTimer.setFailed(!ok);
+            if (ok) {
+                snapshotRows = rows;
+                metrics.addBytes(Operation::SaveSnapshot, image.size());
+            } else {
+                cerr << "Klaida: nepavyko issaugoti " << SnapshotPath << "." << endl;
+            }
+        }
+        if (catalogLock.owns_lock()) catalogLock.unlock();
+        if (!ok || !writeFileAtomically(WaitlistsPath, waitlists) ||
+            !writeFileAtomically("reservations.txt", contents)) {
+            if (ok) cerr << "Klaida: nepavyko issaugoti reservations.txt." << endl;
+            timer.setFailed(true);
+            // Failai liko seni, todel paimti irasai prirasomi prie zurnalo; velesni irasai
+            // lieka pendingRecords ir bus prirasyti po ju
+            if (count > 0 && !journal.append(records, count)) {
+                cerr << "Klaida: nepavyko irasyti i zurnala " << journal.getPath() << "." << endl;
+            }
+            return;
+        }
+        metrics.addBytes(Operation::SaveReservations, contents.size() + waitlists.size());
+        journal.reset();
+    }
+
+    // Kvieciama tik is fonio gijos
+    void writeUsersFile() {
+        OperationTimer timer(Operation::SaveUsers);
+        string contents;
+        {
+            shared_lock<shared_mutex> lock(usersMutex);
+            contents = usersText();
+        }
+        if (!writeFileAtomically("users.txt", contents)) {
+            cerr << "Klaida: nepavyko issaugoti users.txt." << endl;
+            timer.setFailed(true);
+            return;
+        }
+        metrics.addBytes(Operation::SaveUsers, contents.size());
+    }
+
+    // Kvieciama laikant abu uzraktus
+    Status cancelReservationLocked(UserHandle user, ReservationHandle handle) {
+        const Reservation* reservation = reservationPool.get(handle);
+        if (!reservation) return Status::NotFound;
+        if (reservation->getUser() != user) return Status::NotOwner;
+        journalCancellation(reservation); // Įrašome atšaukimą į žurnalą
+        removeReservation(handle, true);
+        return Status::Ok;
+    }
+
+    Status tryReserveItem(UserHandle user, int itemID) {
+        shared_lock<shared_mutex> usersLock(usersMutex);
+        if (!userPool.get(user)) return Status::AuthFailed;
+        ItemHandle itemHandle = findItemByID(itemID);
+        LibraryItem* item = itemOf(itemHandle);
+        if (!item) return Status::NotFound;
+        // Lenktynes del tos pacios knygos laimi tik viena sesija (atomine bito operacija)
+        if (!item->borrowItem()) return Status::Unavailable;
+
+        // Sukuriama nauja rezervacija
+        lock_guard<mutex> lock(reservationMutex);
+        grantReservation(user, itemHandle);
+        return Status::Ok;
+    }
+
+public:
+    // persistent = false - biblioteka atmintyje (apkrovos testui, trasos kartojimui): load() tik
+    // perskaito failus, o pakeitimai i juos nerasomi
+    explicit Library(bool persistent = true) : persistent(persistent) {
+        indexes.publish(make_unique<CatalogIndexes>(titleKeys, authorKeys));
+        if (persistent) persistenceThread = thread(&Library::persistenceLoop, this);
+    }
+
+    // Sustabdo fonio gija, pries tai irasius visus pakeitimus
+    ~Library() {
+        if (!persistenceThread.joinable()) return;
+        {
+            lock_guard<mutex> lock(persistMutex);
+            stopping = true;
+            persistWork.notify_one();
+        }
+        persistenceThread.join();
+    }
+
+    // Ikelia duomenis: kataloga is library.snap, jei jis yra, kitaip is books.txt; vartotojai ir
+    // rezervacijos visada tekstiniuose failuose. Po to pritaikomas rezervaciju zurnalas.
+    // Biblioteka atmintyje failus tik skaito.
+    void load() {
+        OperationTimer timer(Operation::Load);
+        if (::access(SnapshotPath, F_OK) == 0 && loadSnapshot(SnapshotPath)) {
+            storageFormat = StorageFormat::Snapshot;
+            loadUsersFromFile();
+        } else {
+            // Knygos ir vartotojai nepriklausomi, todel kraunami vienu metu; rezervacijos - po ju.
+            // Branduoliai padalijami pagal failu dydi, kad abu krovikliai kartu ju neperpildytu.
+            auto fileSize = [](const char* path) {
+                struct stat info;
+                return ::stat(path, &info) == 0 ? static_cast<size_t>(info.st_size) : 0;
+            };
+            size_t bookBytes = fileSize("books.txt"), userBytes = fileSize("users.txt");
+            size_t workers = parallelChunks();
+            size_t userWorkers = min(max<size_t>(1, workers * userBytes / max<size_t>(1, bookBytes + userBytes)),
+                                     max<size_t>(1, workers - 1));
+            size_t bookWorkers = max<size_t>(1, workers - userWorkers);
+            thread usersLoader([this, userWorkers] { loadUsersFromFile(userWorkers); });
+            loadItemsFromFile(bookWorkers);
+            usersLoader.join();
+        }
+        loadReservationsFromFile();
+        loadWaitlistsFromFile();
+        replayJournal();
+        if (persistent && journal.needsCompaction()) saveReservationsToFile();
+        sortIndexes();
+        if (storageFormat == StorageFormat::Snapshot) catalog.publish(); // Zurnalo 'i' eilutes
+    }
+
+    // Barjeras: grizta, kai visi iki siol pazymeti pakeitimai irasyti i diska
+    void flush() {
+        unique_lock<mutex> lock(persistMutex);
+        if (!persistenceThread.joinable()) return;
+        uint64_t target = submitted;
+        persistDone.wait(lock, [&] { return persisted >= target; });
+    }
+
+    StorageFormat getStorageFormat() const { return storageFormat; }
+
+    // Perraso duomenis kitu formatu ir ji padaro pagrindiniu: katalogas irasomas i library.snap
+    // arba books.txt (tada library.snap pasalinamas), vartotojai ir rezervacijos - visada i
+    // tekstinius failus. Zurnalas isvalomas.
+    bool convertTo(StorageFormat format) {
+        flush();
+        shared_lock<shared_mutex> catalogLock(catalogMutex);
+        unique_lock<shared_mutex> usersLock(usersMutex);
+        lock_guard<mutex> lock(reservationMutex);
+        bool ok;
+        if (format == StorageFormat::Snapshot) {
+            string contents = buildSnapshot();
+            ok = !contents.empty() && writeFileAtomically(SnapshotPath, contents);
+            if (ok) snapshotRows = catalog.size();
+        } else {
+            ok = writeFileAtomically("books.txt", booksText()) && (::unlink(SnapshotPath) == 0 || errno == ENOENT);
+        }
+        if (!ok || !writeFileAtomically("users.txt", usersText()) ||
+            !writeFileAtomically("reservations.txt", reservationsText()) ||
+            !writeFileAtomically(WaitlistsPath, waitlistsText())) {
+            return false;
+        }
+        storageFormat = format;
+        journal.reset();
+        return true;
+    }
+
+    // Truksta duomenu failo - sukuriamas tuscias (biblioteka atmintyje failu nekuria)
+    void createMissingFile(const char* path) {
+        if (!persistent) return;
+        cerr << "Failas " << path << " nerastas. Sukuriamas naujas failas." << endl;
+        ofstream outFile(path);
+    }
+
+    // Surusiuoja atidetus paieskos indeksu irasus (kitaip uz tai sumoketu pirmoji uzklausa)
+    void sortIndexes() { indexes.current()->ensureSorted(); }
+
+    void loadItemsFromFile(size_t workers = parallelChunks()) {
+        MappedFile file;
+        if (!file.open("books.txt")) {
+            createMissingFile("books.txt");
+            return;
+        }
+
+        // Dalys nagrinejamos lygiagreciai, o knygos pridedamos failo tvarka - ID lieka tie patys
+        parseInParallel<ParsedBook>(file.view(), '|', "books.txt",
+            [](const Record& rec, ParsedBook& book, string& error) {
+                if (rec.isBlank()) return false;
+                parseBook(rec, book, error);
+                return true;
+            },
+            [&](ParsedBook& book) {
+                addItem(book.title, book.author, book.year, book.category, book.kind,
+                        book.detail, std::move(book.keys));
+                return string();
+            },
+            0, workers);
+    }
+
+    void setJournalConfig(const JournalConfig& config) {
+        journalConfig = config;
+    }
+
+    // Suspaudzia zurnala ir laukia, kol tai bus padaryta
+    void saveReservationsToFile() {
+        markDirty(false, true);
+        flush();
+    }
+
+    // Baigiant darba suspaudzia zurnala (vartotojai irasomi registruojant). Jei niekas
+    // nepasikeite, failai nelieciami.
+    void save() {
+        saveReservationsToFile();
+    }
+
+    // Rezervacijos ikeliamos paskutines, todel po ju paskelbiama pirma prieinamumo versija;
+    // nuo tada kiekvienas pakeitimas skelbiamas atskirai
+    void loadReservationsFromFile() {
+        MappedFile file;
+        if (!file.open("reservations.txt")) {
+            createMissingFile("reservations.txt");
+            catalog.publish();
+            return;
+        }
+
+        // Laukai ir datos nagrinejami bei knygos randamos lygiagreciai; rezervacijos
+        // sukuriamos failo tvarka, nes pasikartojancios rezervacijos ir nauji vartotojai
+        // priklauso nuo ankstesniu eiluciu
+        struct ParsedReservation {
+            string_view userName, title;
+            bool isAvailable = false;
+            time_t reservedAt = 0, returnBy = 0;
+            ItemHandle item;
+            UserHandle user;
+        };
+        parseInParallel<ParsedReservation>(file.view(), '|', "reservations.txt",
+            [&](const Record& rec, ParsedReservation& res, string& error) {
+                if (rec.isBlank()) return false;
+                const string_view* f = rec.fields;
+                if (rec.count != 7 && rec.count != 9) {
+                    error = "tiketini 9 laukai, rasta " + to_string(rec.count);
+                } else if (f[4] != "0" && f[4] != "1") {
+                    error = "netinkamas prieinamumas '" + string(f[4]) + "'";
+                } else if (!parseTime(f[5], res.reservedAt) || !parseTime(f[6], res.returnBy)) {
+                    error = "netinkama data";
+                } else {
+                    res.userName = f[0];
+                    res.title = f[1];
+                    res.isAvailable = f[4] == "1";
+                    res.item = findRecordItem(rec, 1, 2, 7);
+                    res.user = findUser(f[0]);
+                }
+                return true;
+            },
+            [&](ParsedReservation& res) {
+                LibraryItem* item = itemOf(res.item);
+                if (!item) return "knyga '" + string(res.title) + "' nerasta";
+                if (!res.isAvailable && !item->checkAvailability()) {
+                    return "knyga '" + string(res.title) + "' jau rezervuota";
+                }
+
+                // Jei vartotojas neegzistuoja, sukurti laikiną vartotoją
+                UserHandle user = res.user.valid() ? res.user : findOrAddUser(res.userName);
+
+                if (!res.isAvailable) {
+                    item->borrowItem(); // Pažymėti knyga kaip rezervuotą (laisvumas patikrintas auksciau)
+                }
+                addReservation(user, res.item, res.reservedAt, res.returnBy);
+                return string();
+            });
+        catalog.publish();
+    }
+
+    // Laukimo eiles ikeliamos po rezervaciju: eiles tvarka - failo eiluciu tvarka.
+    // Laisvai knygai eile nereikalinga, todel tokia eilute praleidziama.
+    void loadWaitlistsFromFile() {
+        MappedFile file;
+        if (!file.open(WaitlistsPath)) return; // Eiliu dar nebuvo
+        RecordScanner scanner(file.view(), '|');
+        Record rec;
+        while (scanner.next(rec)) {
+            if (rec.isBlank()) continue;
+            const string_view* f = rec.fields;
+            time_t requestedAt;
+            if ((rec.count != 4 && rec.count != 6) || !parseTime(f[3], requestedAt)) {
+                reportBadLine(WaitlistsPath, rec.lineNumber, "tiketini 6 laukai su data");
+                continue;
+            }
+            ItemHandle item = findRecordItem(rec, 1, 2, 4);
+            const LibraryItem* view = itemOf(item);
+            if (!view) {
+                reportBadLine(WaitlistsPath, rec.lineNumber, "knyga '" + string(f[1]) + "' nerasta");
+            } else if (view->checkAvailability()) {
+                reportBadLine(WaitlistsPath, rec.lineNumber, "knyga '" + string(f[1]) + "' laisva");
+            } else {
+                UserHandle user = findOrAddUser(f[0]);
+                if (!findHold(user, item).valid()) addHold(user, item, requestedAt);
+            }
+        }
+    }
+
+    void loadUsersFromFile(size_t workers = parallelChunks()) {
+        MappedFile file;
+        if (!file.open("users.txt")) {
+            createMissingFile("users.txt");
+            return;
+        }
+
+        struct ParsedUser {
+            string_view name, password;
+        };
+        // Eilute imama visa ir skaidoma pagal bet kokius tarpus ar tabuliacijas, kaip operator>>
+        parseInParallel<ParsedUser>(file.view(), '\n', "users.txt",
+            [](const Record& rec, ParsedUser& user, string& error) {
+                const char* const spaces = " \t\r\v\f";
+                string_view line = rec.fields[0];
+                string_view tokens[2];
+                size_t tokenCount = 0;
+                for (size_t pos = line.find_first_not_of(spaces); pos != string_view::npos;
+                     pos = line.find_first_not_of(spaces, pos)) {
+                    size_t end = min(line.find_first_of(spaces, pos), line.size());
+                    if (tokenCount < 2) tokens[tokenCount] = line.substr(pos, end - pos);
+                    ++tokenCount;
+                    pos = end;
+                }
+                if (tokenCount == 0) return false;
+                if (tokenCount != 2) {
+                    error = "tiketinas vardas ir slaptazodis";
+                } else {
+                    user.name = tokens[0];
+                    user.password = tokens[1];
+                }
+                return true;
+            },
+            [&](ParsedUser& user) {
+                addUser(string(user.name), string(user.password)); // Pasikartojantis vardas - paliekamas pirmasis
+                return string();
+            },
+            0, workers);
+    }
+
+    // Pritaiko reservations.journal ir atidaro ji tolesniems irasams
+    void replayJournal() {
+        const string journalPath = "reservations.journal";
+        MappedFile file;
+        if (file.open(journalPath)) {
+            RecordScanner scanner(file.view(), '|');
+            Record rec;
+            while (scanner.next(rec)) {
+                // Paskutine eilute be '\n' - nebaigtas irasas po gedimo, ignoruojama
+                if (!rec.terminated || rec.isBlank()) continue;
+                replayJournalRecord(rec);
+            }
+        }
+        if (persistent && !journal.open(journalPath, journalConfig)) {
+            cerr << "Klaida: nepavyko atidaryti zurnalo " << journalPath << "." << endl;
+        }
+    }
+
+    void saveUsersToFile() {
+        markDirty(true, false);
+        flush();
+    }
+
+    const CatalogStore& getCatalog() const { return catalog; }
+
+    // Paskelbta indeksu versija; prieinamumo vaizda reikia paimti pries ja
+    using IndexView = Versioned<CatalogIndexes>::ReadGuard;
+    IndexView readIndexes() const { return indexes.read(); }
+
+    const CatalogItem* getItem(size_t row) const { return itemPool.get(items[row]); }
+    const CatalogItem* getItem(ItemHandle handle) const { return itemPool.get(handle); }
+    const User* getUser(UserHandle handle) const { return userPool.get(handle); }
+    const Reservation* getReservation(ReservationHandle handle) const { return reservationPool.get(handle); }
+
+    template <typename Func>
+    void forEachUser(Func f) const {
+        shared_lock<shared_mutex> lock(usersMutex);
+        userPool.forEach(f);
+    }
+
+    // Telkiniu statistika: gyvu objektu skaicius, lizdai ir atmintis; bendru eiluciu zodynu dydis
+    void printPoolStats(ostream& out) const {
+        auto line = [&](const char* name, size_t live, size_t capacity, size_t bytes, size_t slotBytes) {
+            out << "Telkinys " << name << ": gyvu " << live << ", lizdu " << capacity
+                << ", atmintis " << bytes << " B (" << slotBytes << " B lizdui)" << '\n';
+        };
+        line("knygos", itemPool.size(), itemPool.capacity(), itemPool.memoryBytes(), ObjectPool<CatalogItem>::slotBytes());
+        line("vartotojai", userPool.size(), userPool.capacity(), userPool.memoryBytes(), ObjectPool<User>::slotBytes());
+        line("rezervacijos", reservationPool.size(), reservationPool.capacity(), reservationPool.memoryBytes(),
+             ObjectPool<Reservation>::slotBytes());
+        line("laukimai", holdPool.size(), holdPool.capacity(), holdPool.memoryBytes(), ObjectPool<Hold>::slotBytes());
+        out << "Eilutes: skirtingu autoriu " << catalog.authorCount() << ", zanru " << catalog.getCategoryNames().size()
+            << ", pavadinimu raktu " << titleKeys.size() << ", atmintis "
+            << catalog.stringBytes() + titleKeys.bytes() + authorKeys.bytes() << " B" << '\n';
+        out << "Prieinamumo versija: " << catalog.versionNumber() << ", neatlaisvintu senu versiju "
+            << catalog.retiredVersions() << '\n';
+        out.flush();
+    }
+
+    static constexpr size_t SuggestionLimit = 10;  // Kiek pasiulymu grazinama pagal prefiksa
+
+    size_t countAvailableItems() const {
+        return catalog.countAvailable();
+    }
+
+    // Atlaisvina rezervacijas, kuriu atsiemimo laikas praejo iki now; kiekviena - O(log n).
+    // Atlaisvinimas irasomas i zurnala kaip atsaukimas. Grazina atlaisvintu skaiciu.
+    size_t expireOverdue(time_t now) {
+        shared_lock<shared_mutex> usersLock(usersMutex);
+        lock_guard<mutex> lock(reservationMutex);
+        size_t expired = 0;
+        while (!expiryQueue.empty() && expiryQueue.top().returnBy <= now) {
+            ExpiryEntry entry = expiryQueue.top();
+            expiryQueue.pop();
+            const Reservation* res = reservationPool.get(entry.reservation);
+            if (!res || res->getReturnBy() != entry.returnBy) continue; // Jau atsaukta
+            journalCancellation(res);
+            removeReservation(entry.reservation, true);
+            ++expired;
+        }
+        return expired;
+    }
+
+    // Knygos rezervacijos savininkas arba negaliojanti rankena, jei knyga nerezervuota
+    UserHandle holderOf(int itemID) const {
+        lock_guard<mutex> lock(reservationMutex);
+        const Reservation* res = reservationPool.get(findReservation(findItemByID(itemID)));
+        return res ? res->getUser() : UserHandle();
+    }
+
+    // Vartotojo rezervacijos sukurimo tvarka; kaina priklauso tik nuo ju skaiciaus
+    vector<ReservationHandle> reservationsOf(UserHandle user) const {
+        lock_guard<mutex> lock(reservationMutex);
+        vector<ReservationHandle> result;
+        if (!user.valid() || user.index >= reservationsByUser.size()) return result;
+        for (ReservationHandle handle = reservationsByUser[user.index].first; handle.valid();) {
+            const Reservation* res = reservationPool.get(handle);
+            if (!res || res->getUser() != user) break; // Lizdas priklauso kitam (istrintam) vartotojui
+            result.push_back(handle);
+            handle = res->getNextOfUser();
+        }
+        return result;
+    }
+
+    // Grazina negaliojancia rankena, jei vardas ar slaptazodis neteisingi
+    UserHandle authenticate(string_view name, string_view password) const {
+        OperationTimer timer(Operation::Login);
+        shared_lock<shared_mutex> lock(usersMutex);
+        UserHandle handle = findUser(name);
+        const User* user = userPool.get(handle);
+        bool ok = user && user->getPassword() == password;
+        timer.setFailed(!ok);
+        return ok ? handle : UserHandle();
+    }
+
+    Status createUser(const string& name, const string& password) {
+        // Vardas ir slaptazodis saugomi users.txt, atskirti tarpu
+        auto valid = [](const string& text) {
+            return !text.empty() && text.find_first_of(" \t\r\n|") == string::npos;
+        };
+        if (!valid(name) || !valid(password)) return Status::InvalidRequest;
+        unique_lock<shared_mutex> lock(usersMutex);
+        if (!addUser(name, password).valid()) return Status::AlreadyExists;
+        markDirty(true, false); // users.txt perrasys fonio gija
+        return Status::Ok;
+    }
+
+    Status reserveItem(UserHandle user, int itemID) {
+        OperationTimer timer(Operation::Reserve);
+        Status status = tryReserveItem(user, itemID);
+        timer.setFailed(status != Status::Ok);
+        return status;
+    }
+
+    Status cancelReservation(UserHandle user, ReservationHandle handle) {
+        OperationTimer timer(Operation::Cancel);
+        shared_lock<shared_mutex> usersLock(usersMutex);
+        lock_guard<mutex> lock(reservationMutex);
+        Status status = cancelReservationLocked(user, handle);
+        timer.setFailed(status != Status::Ok);
+        return status;
+    }
+
+    Status cancelItemReservation(UserHandle user, int itemID) {
+        OperationTimer timer(Operation::Cancel);
+        ItemHandle item = findItemByID(itemID);
+        if (!item.valid()) {
+            timer.setFailed(true);
+            return Status::NotFound;
+        }
+        shared_lock<shared_mutex> usersLock(usersMutex);
+        lock_guard<mutex> lock(reservationMutex);
+        Status status = cancelReservationLocked(user, findReservation(item));
+        timer.setFailed(status != Status::Ok);
+        return status;
+    }
+
+    // Laisva knyga rezervuojama iskart; uzimta - vartotojas statomas i jos eiles gala
+    // (Status::Queued, position - vieta eileje nuo 1)
+    Status holdItem(UserHandle user, int itemID, size_t& position) {
+        OperationTimer timer(Operation::Hold);
+        shared_lock<shared_mutex> usersLock(usersMutex);
+        ItemHandle itemHandle = findItemByID(itemID);
+        LibraryItem* item = itemOf(itemHandle);
+        Status status = Status::Queued;
+        if (!userPool.get(user)) status = Status::AuthFailed;
+        else if (!item) status = Status::NotFound;
+        if (status != Status::Queued) {
+            timer.setFailed(true);
+            return status;
+        }
+        lock_guard<mutex> lock(reservationMutex);
+        position = 0;
+        // Bitas imamas laikant reservationMutex, todel atsaukimas negali praslysti tarp
+        // nesekmingo bandymo ir atsistojimo i eile
+        if (item->borrowItem()) {
+            grantReservation(user, itemHandle);
+            return Status::Ok;
+        }
+        const Reservation* current = reservationPool.get(findReservation(itemHandle));
+        if ((current && current->getUser() == user) || findHold(user, itemHandle).valid()) {
+            timer.setFailed(true);
+            return Status::AlreadyExists;
+        }
+        HoldHandle handle = addHold(user, itemHandle, time(nullptr));
+        journalHold(holdPool.get(handle));
+        position = holdsByRow[static_cast<uint32_t>(item->getRow())].size;
+        return Status::Queued;
+    }
+
+    Status leaveWaitlist(UserHandle user, int itemID) {
+        OperationTimer timer(Operation::Hold);
+        shared_lock<shared_mutex> usersLock(usersMutex);
+        lock_guard<mutex> lock(reservationMutex);
+        HoldHandle handle = findHold(user, findItemByID(itemID));
+        if (!handle.valid()) {
+            timer.setFailed(true);
+            return Status::NotFound;
+        }
+        journalHoldRemoval(holdPool.get(handle));
+        removeHold(handle);
+        return Status::Ok;
+    }
+
+    // Vartotojo laukiamos knygos ir vieta ju eilese, atsistojimo tvarka
+    vector<pair<ItemHandle, size_t>> holdsOf(UserHandle user) const {
+        shared_lock<shared_mutex> usersLock(usersMutex);
+        lock_guard<mutex> lock(reservationMutex);
+        vector<pair<ItemHandle, size_t>> result;
+        if (!userPool.get(user) || user.index >= holdsByUser.size()) return result;
+        for (HoldHandle handle = holdsByUser[user.index].first; handle.valid();) {
+            const Hold* hold = holdPool.get(handle);
+            result.emplace_back(hold->getItem(), positionInQueue(handle));
+            handle = hold->getNextOfUser();
+        }
+        return result;
+    }
+
+    // Prideda knyga tik atmintyje (sugeneruotam katalogui); kvieciama pries aptarnaujant sesijas
+    int addBook(string_view title, string_view author, int year, string_view category) {
+        ItemHandle handle = addItem(title, author, year, category);
+        catalog.publish();
+        return itemOf(handle)->getID();
+    }
+
+    // Ar kelias rodo i bibliotekos duomenu faila ar jo laikina faila (tas pats katalogas ir
+    // vardas ar vardo pradzia, arba tas pats failas kitu keliu)
+    static bool isDataFile(const string& path) {
+        static const char* const names[] = {"books.txt", "users.txt", "reservations.txt", "reservations.journal",
+                                            WaitlistsPath, SnapshotPath};
+        size_t slash = path.rfind('/');
+        string dir = slash == string::npos ? "." : path.substr(0, slash + 1);
+        string_view name = string_view(path).substr(slash == string::npos ? 0 : slash + 1);
+        struct stat dirInfo, dataDir, target, data;
+        bool sameDir = ::stat(dir.c_str(), &dirInfo) == 0 && ::stat(".", &dataDir) == 0 &&
+                       dirInfo.st_dev == dataDir.st_dev && dirInfo.st_ino == dataDir.st_ino;
+        bool exists = ::stat(path.c_str(), &target) == 0;
+        for (const char* dataName : names) {
+            if (sameDir && name.substr(0, strlen(dataName)) == dataName) return true;
+            if (exists && ::stat(dataName, &data) == 0 && data.st_dev == target.st_dev && data.st_ino == target.st_ino) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Importuoja knygas is books.txt formato ar CSV (pagal pletini) failo, nesustabdant sesiju.
+    // Failas skaitomas blokais, kurie nagrinejami lygiagreciai, todel atmintyje vienu metu
+    // laikomas tik vienas blokas. CSV pirma eilute su nesveikaisiais metais laikoma antraste.
+    // Pasikartojancios (jau esancios kataloge ar anksciau faile) knygos praleidziamos.
+    Status importItems(const string& path, size_t& added, size_t& duplicates, size_t& rejected) {
+        OperationTimer timer(Operation::Import);
+        added = duplicates = rejected = 0;
+        if (isDataFile(path)) {
+            timer.setFailed(true);
+            return Status::Forbidden;
+        }
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            timer.setFailed(true);
+            return Status::NotFound;
+        }
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        // Tekstiniu failu rezimu naujos knygos prirasomos prie books.txt, o library.snap
+        // perrasomas baigus importa
+        int booksFd = -1;
+        if (persistent && storageFormat == StorageFormat::Text) {
+            booksFd = ::open("books.txt", O_WRONLY | O_APPEND | O_CREAT, 0644);
+            struct stat info;
+            char last = '\n';
+            if (booksFd >= 0 && ::fstat(booksFd, &info) == 0 && info.st_size > 0) {
+                int reader = ::open("books.txt", O_RDONLY);
+                if (reader >= 0 && ::pread(reader, &last, 1, info.st_size - 1) != 1) last = '\n';
+                if (reader >= 0) ::close(reader);
+            }
+            if (last != '\n') writeFully(booksFd, "\n");
+        }
+
+        bool csv = isCsvPath(path);
+        vector<char> block(parallelChunks() * ParseChunkBytes);
+        size_t filled = 0, lines = 0;
+        uint64_t bytes = 0;
+        bool eof = false, failed = false;
+        atomic<size_t> badLines{0};
+        vector<ParsedBook> books;
+        while (!eof || filled > 0) {
+            while (!eof && filled < block.size()) {
+                ssize_t count = ::read(fd, block.data() + filled, block.size() - filled);
+                if (count < 0 && errno == EINTR) continue;
+                if (count <= 0) {
+                    failed = count < 0;
+                    eof = true;
+                    break;
+                }
+                filled += static_cast<size_t>(count);
+                bytes += static_cast<uint64_t>(count);
+            }
+            // Blokas baigiamas ties paskutine pilna eilute; eilute ilgesne uz bloka - blokas didinamas
+            size_t used = filled;
+            if (!eof) {
+                const char* end = static_cast<const char*>(memrchr(block.data(), '\n', filled));
+                if (!end) {
+                    block.resize(block.size() * 2);
+                    continue;
+                }
+                used = static_cast<size_t>(end - block.data()) + 1;
+            }
+            char* base = block.data();
+            string_view data(base, used);
+            bool first = lines == 0;
+            books.clear();
+            lines = parseInParallel<ParsedBook>(data, csv ? '\n' : '|', path,
+                [&](const Record& line, ParsedBook& book, string& error) {
+                    if (line.isBlank()) return false;
+                    Record rec = line;
+                    if (csv) {
+                        // CSV eilute skaidoma bloke vietoje (blokas priklauso importui)
+                        char* begin = base + (line.fields[0].data() - data.data());
+                        if (!splitCsvLine(begin, begin + line.fields[0].size(), rec)) {
+                            error = "netinkamos kabutes";
+                            ++badLines;
+                            return true;
+                        }
+                        if (first && line.fields[0].data() == data.data() && rec.count >= 3 &&
+                            !parseInt(rec.fields[2], book.year)) {
+                            return false; // Antraste
+                        }
+                    }
+                    parseBook(rec, book, error);
+                    if (!error.empty()) ++badLines;
+                    return true;
+                },
+                [&](ParsedBook& book) {
+                    books.push_back(std::move(book));
+                    return string();
+                },
+                lines);
+            mergeImported(books, booksFd, added, duplicates, rejected);
+            memmove(block.data(), block.data() + used, filled - used);
+            filled -= used;
+        }
+        ::close(fd);
+        rejected += badLines;
+
+        {
+            // Paskelbiamos likusios eilutes; atsargine kopija nebereikalinga
+            unique_lock<shared_mutex> catalogLock(catalogMutex);
+            if (!pendingRows.empty()) publishIndexes();
+            spareIndexes.reset();
+            laggingRows.clear();
+        }
+        if (booksFd >= 0) {
+            if (::fsync(booksFd) != 0) failed = true;
+            ::close(booksFd);
+        }
+        if (persistent && storageFormat == StorageFormat::Snapshot && added > 0) saveReservationsToFile();
+        metrics.addBytes(Operation::Import, bytes);
+        timer.setFailed(failed);
+        return failed ? Status::InvalidRequest : Status::Ok;
+    }
+
+    // Eksportuoja kataloga books.txt formatu ar CSV (pagal pletini). Eilutes formuojamos
+    // blokais, kiekvienam blokui trumpam uzrakinant kataloga, ir rasomos i unikalu laikina
+    // faila (mkstemp), kuris pabaigoje pervadinamas. Biblioteka atmintyje (trasos kartojimas)
+    // eilutes suformuoja, bet failo nekuria ir neraso.
+    Status exportItems(const string& path, size_t& exported) {
+        OperationTimer timer(Operation::Export);
+        const size_t BlockRows = 16384;
+        exported = 0;
+        if (isDataFile(path)) {
+            timer.setFailed(true);
+            return Status::Forbidden;
+        }
+        string tmpPath = path + ".XXXXXX";
+        int fd = persistent ? ::mkstemp(&tmpPath[0]) : -1;
+        if (persistent && (fd < 0 || ::fchmod(fd, 0644) != 0)) {
+            if (fd >= 0) {
+                ::close(fd);
+                ::unlink(tmpPath.c_str());
+            }
+            timer.setFailed(true);
+            return Status::InvalidRequest;
+        }
+        bool csv = isCsvPath(path);
+        string buffer = csv ? "pavadinimas,autorius,metai,zanras,rusis,numeris\n" : "";
+        uint64_t bytes = 0;
+        bool ok = true;
+        for (size_t begin = 0; ok; begin += BlockRows) {
+            {
+                shared_lock<shared_mutex> catalogLock(catalogMutex);
+                size_t end = min(catalog.size(), begin + BlockRows);
+                for (size_t row = begin; row < end; ++row) {
+                    if (appendItemRecord(buffer, row, csv)) ++exported;
+                }
+            }
+            if (buffer.empty()) break;
+            if (persistent) ok = writeFully(fd, buffer);
+            bytes += buffer.size();
+            buffer.clear();
+        }
+        if (persistent) {
+            ok = ::fsync(fd) == 0 && ok;
+            ok = ::close(fd) == 0 && ok;
+            ok = ok && rename(tmpPath.c_str(), path.c_str()) == 0;
+            if (!ok) ::unlink(tmpPath.c_str());
+        }
+        metrics.addBytes(Operation::Export, bytes);
+        timer.setFailed(!ok);
+        return ok ? Status::Ok : Status::InvalidRequest;
+    }
+
+    // Paieskos uzklausos vykdomos be uzraktu: prieinamumo vaizdas imamas pries indeksu versija,
+    // todel visos vaizdo eilutes yra ir indeksuose (importas juos skelbia pirmus)
+    Result query(const Request& request) const {
+        Result result;
+        CatalogSnapshot view = catalog.snapshot();
+        IndexView index = readIndexes();
+        auto collect = [&](const auto& rows) {
+            size_t begin = min(rows.size(), request.offset);
+            size_t end = begin + min(rows.size() - begin, request.limit);
+            result.itemIDs.reserve(end - begin);
+            for (size_t i = begin; i < end; ++i) result.itemIDs.push_back(index->ids[rows[i]]);
+        };
+        switch (request.type) {
+            case RequestType::Available:
+                // Puslapis imamas is vienos versijos, nors kitos sesijos tuo metu rezervuoja
+                view.forEachAvailable([&](size_t row) { result.itemIDs.push_back(index->ids[row]); },
+                                      request.offset, request.limit);
+                break;
+            case RequestType::Filter: {
+                RowSpan rows;
+                if (index->findByCategory(request.category, rows)) collect(rows);
+                else result.status = Status::NotFound;
+                break;
+            }
+            case RequestType::Search:
+                collect(index->search(request.category, request.words));
+                break;
+            case RequestType::Years: {
+                vector<uint32_t> rows;
+                size_t total = index->findByYears(request.category, request.fromYear, request.toYear, request.offset,
+                                                  request.limit, rows);
+                if (total == 0) result.status = Status::NotFound;
+                for (uint32_t row : rows) result.itemIDs.push_back(index->ids[row]);
+                break;
+            }
+            case RequestType::Complete:
+                for (uint32_t row : index->completeAvailable(view, request.words, min(request.limit, SuggestionLimit))) {
+                    result.itemIDs.push_back(index->ids[row]);
+                }
+                break;
+            default:
+                result.status = Status::InvalidRequest;
+        }
+        return result;
+    }
+
+    Result execute(const Request& request) {
+        Result result;
+        switch (request.type) {
+            case RequestType::Import:
+            case RequestType::Export: {
+                size_t counts[3] = {};
+                size_t countNumber = 3;
+                if (request.type == RequestType::Import) {
+                    result.status = importItems(request.path, counts[0], counts[1], counts[2]);
+                } else {
+                    result.status = exportItems(request.path, counts[0]);
+                    countNumber = 1;
+                }
+                if (result.status == Status::Ok) result.counts.assign(counts, counts + countNumber);
+                return result;
+            }
+            case RequestType::Available:
+            case RequestType::Filter:
+            case RequestType::Search:
+            case RequestType::Years:
+            case RequestType::Complete:
+                return query(request);
+            case RequestType::Register:
+                result.status = createUser(request.user, request.password);
+                return result;
+            case RequestType::Login:
+                result.status = authenticate(request.user, request.password).valid() ? Status::Ok : Status::AuthFailed;
+                return result;
+            default:
+                break;
+        }
+        // Importas katalogo nekeicia, kol rasytojas iesko knygos pagal ID
+        shared_lock<shared_mutex> catalogLock(catalogMutex);
+        switch (request.type) {
+            case RequestType::Reserve:
+                result.status = reserveItem(findUserLocked(request.user), request.itemID);
+                break;
+            case RequestType::Cancel: {
+                UserHandle user = findUserLocked(request.user);
+                result.status = user.valid() ? cancelItemReservation(user, request.itemID) : Status::AuthFailed;
+                break;
+            }
+            case RequestType::Hold:
+            case RequestType::Unhold: {
+                UserHandle user = findUserLocked(request.user);
+                if (!user.valid()) result.status = Status::AuthFailed;
+                else if (request.type == RequestType::Hold) result.status = holdItem(user, request.itemID, result.position);
+                else result.status = leaveWaitlist(user, request.itemID);
+                break;
+            }
+            default:
+                break; // Ivykdyta auksciau
+        }
+        return result;
+    }
+};
+
+// Interaktyvi bibliotekos sasaja: meniu, ivestis is cin ir isvestis i cout
+class LibraryConsole {
+private:
+    Library& library;
+    UserHandle loggedInUser;  // Negaliojanti rankena - niekas neprisijunges
+    size_t pageSize;  // Eiluciu skaicius puslapyje (0 - rodyti viska)
+
+    // Knygu lenteles antraste
+    static void renderHeader(OutputBuffer& out, const string& title) {
+        renderTitle(out, title);
+        out.text("| ID  | ").padded("Pavadinimas", 25)
+           .text("| ").padded("Autorius", 20)
+           .text("| ").padded("Metai", 4)
+           .text("| ").padded("Zanras", 10)
+           .text("| Statusas |");
+        out.endLine();
+        renderLine(out, 80);
+    }
+
+    // Knygos eilute; busena imama is puslapio vaizdo, todel visas puslapis atitinka viena versija
+    void renderRow(OutputBuffer& out, const CatalogSnapshot& view, size_t row) const {
+        out.text("| ").paddedNumber(library.getCatalog().getID(row), 4).text("|");
+        renderItem(out, *library.getItem(row), view.isAvailable(row));
+    }
+
+    // Rodo sarasa puslapiais. renderPage(out, offset, limit) iraso viena puslapi;
+    // tarp puslapiu vartotojas pasirenka, ar testi.
+    template <typename RenderPage>
+    void browse(size_t total, RenderPage renderPage) const {
+        size_t limit = pageSize ? pageSize : max<size_t>(total, 1);
+        size_t offset = 0;
+        while (true) {
+            {
+                OutputBuffer out(cout);
+                renderPage(out, offset, limit);
+            }
+            if (offset + limit >= total) return;
+            cout << "Rodoma " << offset + 1 << "-" << offset + limit << " is " << total
+                 << ". n - kitas puslapis, p - ankstesnis, q - baigti: ";
+            string answer;
+            if (!(cin >> answer)) return;
+            if (answer == "n") offset += limit;
+            else if (answer == "p") offset = offset >= limit ? offset - limit : 0;
+            else return;
+        }
+    }
+
+    // Rodo eilutes is saraso (zanro ar paieskos rezultatai) puslapiais
+    void browseRows(const string& title, const vector<uint32_t>& rows) const {
+        browse(rows.size(), [&](OutputBuffer& out, size_t offset, size_t limit) {
+            CatalogSnapshot view = library.getCatalog().snapshot();
+            renderHeader(out, title);
+            size_t end = min(rows.size(), offset + limit);
+            for (size_t i = offset; i < end; ++i) renderRow(out, view, rows[i]);
+            if (rows.empty()) {
+                out.text("| Rezultatu nerasta.");
+                out.endLine();
+            }
+            renderLine(out, 80);
+        });
+    }
+
+    // Pirmos limit laisvu knygu, pradedant nuo offset
+    void renderAvailable(OutputBuffer& out, const CatalogSnapshot& view, size_t offset, size_t limit) const {
+        renderHeader(out, "Laisvos Knygos");
+        // Einama tik per laisvu knygu bitus vaizde
+        view.forEachAvailable([&](size_t row) { renderRow(out, view, row); }, offset, limit);
+        if (view.countAvailable() == 0) {
+            out.text("| Visos knygos yra rezervuotos.");
+            out.endLine();
+        }
+        renderLine(out, 80);
+    }
+
+public:
+    explicit LibraryConsole(Library& library, size_t pageSize = 20) : library(library), pageSize(pageSize) {}
+
+    void displayItems() const {
+        const CatalogStore& catalog = library.getCatalog();
+        browse(catalog.size(), [&](OutputBuffer& out, size_t offset, size_t limit) {
+            CatalogSnapshot view = catalog.snapshot();
+            renderHeader(out, "Visos Bibliotekos Knygos");
+            catalog.forEachRow([&](size_t row) { renderRow(out, view, row); }, offset, limit);
+            renderLine(out, 80);
+        });
+    }
+
+    // Kiekvienas puslapis imamas is naujo vaizdo, o laukiant vartotojo vaizdas nelaikomas
+    void displayAvailableItems() const {
+        size_t total = library.getCatalog().snapshot().countAvailable();
+        browse(total, [&](OutputBuffer& out, size_t offset, size_t limit) {
+            renderAvailable(out, library.getCatalog().snapshot(), offset, limit);
+        });
+    }
+
+    // Pirmu pageSize laisvu knygu perziura (be puslapiavimo)
+    void displayTopAvailableItems() const {
+        CatalogSnapshot view = library.getCatalog().snapshot();
+        size_t total = view.countAvailable();
+        size_t limit = pageSize ? pageSize : total;
+        OutputBuffer out(cout);
+        renderAvailable(out, view, 0, limit);
+        if (total > limit) {
+            out.text("| Rodomos pirmos ").number(static_cast<long long>(limit))
+               .text(" is ").number(static_cast<long long>(total))
+               .text(" laisvu knygu. Kitas rasite per paieska.");
+            out.endLine();
+        }
+    }
+
+    // Filtras pagal zanra ir (ar) metu intervala; nurodzius metus knygos rodomos metu tvarka,
+    // o kiekvienas puslapis imamas is tvarkingo indekso. Indeksu versija laikoma tik
+    // sudarant sarasa ar puslapi, ne laukiant vartotojo.
+    void filterByCategory() const {
+        string query, years;
+        cout << "Iveskite zanra (arba palikite tuscia): ";
+        cin.ignore();
+        getline(cin, query);
+        cout << "Iveskite metus ar ju intervala, pvz. 1850-1900 (arba palikite tuscia): ";
+        getline(cin, years);
+
+        if (normalizeKey(years).empty()) {
+            if (normalizeKey(query).empty()) {
+                printTitle("Filtruoti Pagal Zanra");
+                cout << "| Nenurodytas nei zanras, nei metai." << endl;
+                printLine();
+                return;
             }
+            vector<uint32_t> rows;
+            {
+                Library::IndexView index = library.readIndexes();
+                RowSpan found;
+                if (index->findByCategory(query, found)) rows.assign(found.begin(), found.end());
+            }
+            browseRows("Filtruoti Pagal Zanra", rows);
+            return;
         }
-        if (!found) {
-            cout << "| Visos knygos yra rezervuotos." << endl;
+        int fromYear = 0, toYear = 0;
+        if (!parseYearRange(normalizeKey(years), fromYear, toYear)) {
+            cout << "Klaida: metai turi buti skaicius arba intervalas NUO-IKI." << endl;
+            return;
         }
-        printLine(80);
+        vector<uint32_t> page;
+        size_t total = library.readIndexes()->findByYears(query, fromYear, toYear, 0, 0, page);
+        browse(total, [&](OutputBuffer& out, size_t offset, size_t limit) {
+            page.clear();
+            library.readIndexes()->findByYears(query, fromYear, toYear, offset, limit, page);
+            CatalogSnapshot view = library.getCatalog().snapshot();
+            renderHeader(out, "Filtruoti Pagal Metus");
+            for (uint32_t row : page) renderRow(out, view, row);
+            if (total == 0) {
+                out.text("| Rezultatu nerasta.");
+                out.endLine();
+            }
+            renderLine(out, 80);
+        });
     }
 
-    void filterByCategory() const {
-        string query;
-        cout << "Iveskite zanra: ";
+    void searchCatalog() const {
+        string category, words;
+        cout << "Iveskite zanra (arba palikite tuscia): ";
         cin.ignore();
-        getline(cin, query);
-
-        transform(query.begin(), query.end(), query.begin(), ::tolower);
+        getline(cin, category);
+        cout << "Iveskite pavadinimo ar autoriaus zodzius: ";
+        getline(cin, words);
 
-        printTitle("Filtruoti Pagal Zanra");
-        bool found = false;
-        for (const auto& item : items) {
-            string itemCategory = item->getCategory();
-            transform(itemCategory.begin(), itemCategory.end(), itemCategory.begin(), ::tolower);
-            if (itemCategory == query) {
-                item->displayInfo();
-                found = true;
-            }
-        }
-        if (!found) {
-            cout << "| Rezultatu nerasta." << endl;
+        if (normalizeKey(category).empty() && tokenize(words).empty()) {
+            printTitle("Paieskos Rezultatai");
+            cout << "| Nenurodyta, ko ieskoti." << endl;
+            printLine();
+            return;
         }
-        printLine();
+        browseRows("Paieskos Rezultatai", library.readIndexes()->search(category, words));
     }
 
     void registerUser() {
@@ -350,8 +4322,10 @@ public:
         cin >> name;
         cout << "Iveskite slaptazodi: ";
         cin >> password;
-        users.push_back(new User(name, password));
-        saveUsersToFile(); // Isaugome vartotojus i faila
+        if (library.createUser(name, password) != Status::Ok) {
+            cout << "Klaida: vartotojas tokiu vardu jau egzistuoja." << endl;
+            return;
+        }
         cout << "Vartotojas sekmingai uzregistruotas!" << endl;
     }
 
@@ -362,56 +4336,60 @@ public:
         cout << "Iveskite slaptazodi: ";
         cin >> password;
 
-        for (auto& user : users) {
-            if (user->getName() == name && user->getPassword() == password) {
-                loggedInUser = user;
-                cout << "Sveiki sugrize, " << name << "!" << endl;
-                int action;
-                do {
-                    printTitle("Prisijungusio Vartotojo Meniu");
-                    cout << "1. Perziureti visas knygas\n";
-                    cout << "2. Perziureti laisvas knygas\n";
-                    cout << "3. Filtruoti pagal zanra\n";
-                    cout << "4. Rezervuoti knyga\n";
-                    cout << "5. Perziureti rezervacijas\n";
-                    cout << "6. Redaguoti rezervacija\n";
-                    cout << "7. Atsijungti\n";
-                    printLine();
-                    cout << "Pasirinkimas: ";
-                    cin >> action;
-
-                    if (cin.fail()) {
-                        cin.clear();
-                        cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                        cout << "Klaida: pasirinkimas turi buti skaicius nuo 1 iki 7." << endl;
-                        continue;
-                    }
-
-                    switch (action) {
-                        case 1: displayItems(); break;
-                        case 2: displayAvailableItems(); break;
-                        case 3: filterByCategory(); break;
-                        case 4: makeReservation(); break;
-                        case 5: displayReservations(); break;
-                        case 6: editReservation(); break;
-                        case 7:
-                            cout << "Atsijungiate nuo paskyros." << endl;
-                            loggedInUser = nullptr; // Išvalome prisijungimo duomenis
-                            return; // Grįžtame į pagrindinį meniu
-                        default:
-                            cout << "Klaida: pasirinkimas turi buti nuo 1 iki 7." << endl;
-                    }
-                } while (action != 7);
+        UserHandle user = library.authenticate(name, password);
+        if (!user.valid()) {
+            cout << "Prisijungimo klaida: neteisingas vardas arba slaptazodis." << endl;
+            return;
+        }
+        loggedInUser = user;
+        cout << "Sveiki sugrize, " << name << "!" << endl;
+        int action;
+        do {
+            library.expireOverdue(time(nullptr));
+            printTitle("Prisijungusio Vartotojo Meniu");
+            cout << "1. Perziureti visas knygas\n";
+            cout << "2. Perziureti laisvas knygas\n";
+            cout << "3. Filtruoti pagal zanra ir metus\n";
+            cout << "4. Ieskoti pagal zanra ir zodzius\n";
+            cout << "5. Rezervuoti knyga\n";
+            cout << "6. Perziureti rezervacijas\n";
+            cout << "7. Redaguoti rezervacija\n";
+            cout << "8. Atsijungti\n";
+            printLine();
+            cout << "Pasirinkimas: ";
+            cin >> action;
 
-                return;
+            if (cin.fail()) {
+                if (cin.eof()) { // Ivestis baigesi
+                    loggedInUser = UserHandle();
+                    return;
+                }
+                cin.clear();
+                cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                cout << "Klaida: pasirinkimas turi buti skaicius nuo 1 iki 8." << endl;
+                continue;
             }
-        }
 
-        cout << "Prisijungimo klaida: neteisingas vardas arba slaptazodis." << endl;
+            switch (action) {
+                case 1: displayItems(); break;
+                case 2: displayAvailableItems(); break;
+                case 3: filterByCategory(); break;
+                case 4: searchCatalog(); break;
+                case 5: makeReservation(); break;
+                case 6: displayReservations(); break;
+                case 7: editReservation(); break;
+                case 8:
+                    cout << "Atsijungiate nuo paskyros." << endl;
+                    loggedInUser = UserHandle(); // Išvalome prisijungimo duomenis
+                    return; // Grįžtame į pagrindinį meniu
+                default:
+                    cout << "Klaida: pasirinkimas turi buti nuo 1 iki 8." << endl;
+            }
+        } while (action != 8);
     }
 
     void makeReservation() {
-        if (!loggedInUser) {
+        if (!library.getUser(loggedInUser)) {
             printTitle("Rezervacija Negalima");
             cout << "| Norint rezervuoti knyga, turite buti prisijunge.            |" << endl;
             cout << "| Jeigu paskyros neturite, rekomenduojame sia susikurti.          |" << endl;
@@ -419,68 +4397,97 @@ public:
             return;
         }
 
-        displayAvailableItems();
+        // Ivedus pavadinimo ar autoriaus pradzia rodomi tik atitinkantys pasiulymai,
+        // skaicius laikomas knygos ID, o tuscia eilute rodo pirmas laisvas knygas
+        string query;
+        cout << "Iveskite pavadinimo ar autoriaus pradzia, knygos ID arba palikite tuscia: ";
+        cin.ignore();
+        getline(cin, query);
 
         int itemID;
-        cout << "Pasirinkite knygos ID: ";
-        cin >> itemID;
-
-        if (cin.fail()) {
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            cout << "Klaida: neteisingas pasirinkimas." << endl;
-            return;
-        }
-
-        LibraryItem* selectedItem = nullptr;
+        if (!parseInt(query, itemID)) {
+            if (normalizeKey(query).empty()) {
+                displayTopAvailableItems();
+            } else {
+                CatalogSnapshot view = library.getCatalog().snapshot();
+                vector<uint32_t> rows = library.readIndexes()->completeAvailable(view, query, Library::SuggestionLimit);
+                if (rows.empty()) {
+                    cout << "Laisvu knygu, prasidedanciu \"" << query << "\", nerasta." << endl;
+                    return;
+                }
+                OutputBuffer out(cout);
+                renderHeader(out, "Pasiulymai");
+                for (uint32_t row : rows) renderRow(out, view, row);
+                renderLine(out, 80);
+            }
 
-        // Ieškome elemento pagal ID
-        for (auto& item : items) {
-            if (item->getID() == itemID) {
-                selectedItem = item;
-                break;
+            cout << "Pasirinkite knygos ID: ";
+            cin >> itemID;
+            if (cin.fail()) {
+                cin.clear();
+                cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                cout << "Klaida: neteisingas pasirinkimas." << endl;
+                return;
             }
         }
 
-        if (!selectedItem) {
-            cout << "Klaida: pasirinkta knyga nerasta." << endl;
-            return;
+        switch (library.reserveItem(loggedInUser, itemID)) {
+            case Status::Ok:
+                cout << "Rezervacija sekminga!" << endl;
+                break;
+            case Status::Unavailable:
+                cout << "Pasirinkta knyga jau rezervuota." << endl;
+                joinWaitlist(itemID);
+                break;
+            default:
+                cout << "Klaida: pasirinkta knyga nerasta." << endl;
         }
+    }
 
-        if (!selectedItem->checkAvailability()) {
-            cout << "Klaida: pasirinkta knyga jau rezervuota. Pasirinkite kita." << endl;
-            return;
+    // Uzimtos knygos laukimo eile: atsilaisvinusi knyga pirmajam eileje rezervuojama automatiskai
+    void joinWaitlist(int itemID) {
+        char answer;
+        cout << "Ar norite stoti i laukimo eile? (t/n): ";
+        cin >> answer;
+        if (cin.fail() || (answer != 't' && answer != 'T')) return;
+        size_t position = 0;
+        switch (library.holdItem(loggedInUser, itemID, position)) {
+            case Status::Queued:
+                cout << "Jus esate " << position << "-as eileje. Kai knyga atsilaisvins, ji bus rezervuota jums." << endl;
+                break;
+            case Status::Ok:
+                cout << "Knyga ka tik atsilaisvino - rezervacija sekminga!" << endl;
+                break;
+            case Status::AlreadyExists:
+                cout << "Jus jau rezervavote sia knyga arba laukiate jos eileje." << endl;
+                break;
+            default:
+                cout << "Klaida: pasirinkta knyga nerasta." << endl;
         }
-
-        // Sukuriama nauja rezervacija
-        Reservation* newReservation = new Reservation(loggedInUser, selectedItem);
-
-        selectedItem->borrowItem();
-        reservations.push_back(newReservation);
-        saveReservationsToFile(); // Išsaugo rezervacijas faile
-        cout << "Rezervacija sekminga!" << endl;
     }
 
     void editReservation() {
-        if (!loggedInUser) {
+        if (!library.getUser(loggedInUser)) {
             printTitle("Rezervaciju Redagavimas");
             cout << "| Norint redaguoti rezervacijas, turite buti prisijunge.          |" << endl;
             printLine(60);
             return;
         }
 
-        // Atvaizduojame visas vartotojo rezervacijas
+        // Atvaizduojame visas vartotojo rezervacijas, o po ju - laukimo eiles
         printTitle("Jusu Rezervacijos");
-        vector<Reservation*> userReservations;
-        for (size_t i = 0; i < reservations.size(); ++i) {
-            if (reservations[i]->getUser() == loggedInUser) {
-                userReservations.push_back(reservations[i]);
-                cout << "| " << userReservations.size() << ". " << setw(40) << left << reservations[i]->getItem()->getTitle() << "|" << endl;
-            }
+        vector<ReservationHandle> userReservations = library.reservationsOf(loggedInUser);
+        vector<pair<ItemHandle, size_t>> holds = library.holdsOf(loggedInUser);
+        for (size_t i = 0; i < userReservations.size(); ++i) {
+            const Reservation* res = library.getReservation(userReservations[i]);
+            cout << "| " << i + 1 << ". " << setw(40) << left << asItem(*library.getItem(res->getItem())).getTitle() << "|" << endl;
+        }
+        for (size_t i = 0; i < holds.size(); ++i) {
+            string label = string(asItem(*library.getItem(holds[i].first)).getTitle()) + " (eileje " + to_string(holds[i].second) + ")";
+            cout << "| " << userReservations.size() + i + 1 << ". " << setw(40) << left << label << "|" << endl;
         }
         printLine(60);
-
-        if (userReservations.empty()) {
+        if (userReservations.empty() && holds.empty()) {
             cout << "| Neturite aktyviu rezervaciju.                                    |" << endl;
             printLine(60);
             return;
@@ -494,17 +4501,18 @@ public:
 
         if (choice == 0) return;
 
-        if (choice < 1 || choice > userReservations.size()) {
+        if (choice < 1 || static_cast<size_t>(choice) > userReservations.size() + holds.size()) {
             cout << "| Netinkamas pasirinkimas.                                         |" << endl;
             printLine(60);
             return;
         }
 
-        Reservation* selectedReservation = userReservations[choice - 1];
+        bool isHold = static_cast<size_t>(choice) > userReservations.size();
 
         // Rezervacijos redagavimo meniu
         printTitle("Rezervacijos Redagavimas");
-        cout << "| 1. Atsaukti rezervacija                                          |" << endl;
+        if (isHold) cout << "| 1. Palikti laukimo eile                                          |" << endl;
+        else cout << "| 1. Atsaukti rezervacija                                          |" << endl;
         cout << "| 2. Grizti atgal                                                  |" << endl;
         printLine(60);
         cout << "Pasirinkimas: ";
@@ -513,11 +4521,14 @@ public:
 
         switch (action) {
             case 1:
-                selectedReservation->cancelReservation();
-                reservations.erase(remove(reservations.begin(), reservations.end(), selectedReservation), reservations.end());
-                delete selectedReservation;
-                saveReservationsToFile(); // Išsaugome atnaujintas rezervacijas faile
-                cout << "| Rezervacija sekmingai atsaukta.                                 |" << endl;
+                if (isHold) {
+                    const LibraryItem& item = asItem(*library.getItem(holds[choice - 1 - userReservations.size()].first));
+                    library.leaveWaitlist(loggedInUser, item.getID());
+                    cout << "| Laukimo eile palikta.                                           |" << endl;
+                } else {
+                    library.cancelReservation(loggedInUser, userReservations[choice - 1]);
+                    cout << "| Rezervacija sekmingai atsaukta.                                 |" << endl;
+                }
                 break;
             case 2:
                 cout << "| Griztama atgal.                                                  |" << endl;
@@ -529,27 +4540,1144 @@ public:
     }
 
     void displayReservations() const {
-        if (!loggedInUser) {
+        if (!library.getUser(loggedInUser)) {
             cout << "Norint perziureti rezervacijas, turite buti prisijunge." << endl;
             return;
         }
 
         printTitle("Jusu Rezervacijos");
-        for (const auto& res : reservations) {
-            if (res->getUser() == loggedInUser) {
-                res->displayReservationInfo();
+        for (ReservationHandle handle : library.reservationsOf(loggedInUser)) {
+            const Reservation* res = library.getReservation(handle);
+            res->displayReservationInfo(*library.getUser(res->getUser()), *library.getItem(res->getItem()));
+        }
+        for (const auto& hold : library.holdsOf(loggedInUser)) {
+            cout << "Laukiama: " << asItem(*library.getItem(hold.first)).getTitle()
+                 << " (vieta eileje: " << hold.second << ")" << endl;
+        }
+    }
+};
+
+// Funkcija eilutei isskaidyti i zodzius pagal tarpus
+vector<string_view> splitWords(string_view line) {
+    vector<string_view> words;
+    size_t pos = 0;
+    while (true) {
+        pos = line.find_first_not_of(" \t\r", pos);
+        if (pos == string_view::npos) return words;
+        size_t end = line.find_first_of(" \t\r", pos);
+        if (end == string_view::npos) end = line.size();
+        words.push_back(line.substr(pos, end - pos));
+        pos = end;
+    }
+}
+
+// Funkcija paketo eilutei paversti uzklausa; grazina false, jei eilute netinkama.
+// Formatai: register|login <vardas> <slaptazodis>, reserve|cancel|hold|unhold [vardas] <ID>,
+// available [nuo] [kiek], filter <zanras>, search <zanras>|<zodziai>, complete <pradzia>,
+// years <nuo> <iki> [praleisti kiek] [zanras], import|export <failas>.
+// Be vardo reserve|cancel|hold|unhold taikomi prisijungusiam sesijos vartotojui.
+bool parseRequest(string_view line, Request& request) {
+    vector<string_view> words = splitWords(line);
+    if (words.empty()) return false;
+    string_view command = words[0];
+    // Likusi eilutes dalis po komandos (zanrai gali tureti tarpu)
+    size_t restStart = static_cast<size_t>(command.data() + command.size() - line.data());
+    string_view rest = line.substr(restStart);
+
+    request = Request();
+    if ((command == "register" || command == "login") && words.size() == 3) {
+        request.type = command == "register" ? RequestType::Register : RequestType::Login;
+        request.user = string(words[1]);
+        request.password = string(words[2]);
+        return true;
+    }
+    bool itemCommand = command == "reserve" || command == "cancel" || command == "hold" || command == "unhold";
+    if (itemCommand && (words.size() == 2 || words.size() == 3)) {
+        if (command == "reserve") request.type = RequestType::Reserve;
+        else if (command == "cancel") request.type = RequestType::Cancel;
+        else request.type = command == "hold" ? RequestType::Hold : RequestType::Unhold;
+        if (words.size() == 3) request.user = string(words[1]);
+        return parseInt(words.back(), request.itemID);
+    }
+    if (command == "available" && words.size() <= 3) {
+        request.type = RequestType::Available;
+        int offset = 0, limit = 0;
+        if (words.size() >= 2) {
+            if (!parseInt(words[1], offset) || offset < 0) return false;
+            request.offset = static_cast<size_t>(offset);
+        }
+        if (words.size() == 3) {
+            if (!parseInt(words[2], limit) || limit < 0) return false;
+            request.limit = static_cast<size_t>(limit);
+        }
+        return true;
+    }
+    if (command == "filter" && words.size() > 1) {
+        request.type = RequestType::Filter;
+        request.category = string(rest);
+        return true;
+    }
+    if (command == "years" && words.size() >= 3) {
+        request.type = RequestType::Years;
+        if (!parseInt(words[1], request.fromYear) || !parseInt(words[2], request.toYear)) return false;
+        size_t categoryWord = 3;
+        int offset = 0, limit = 0;
+        if (words.size() >= 5 && parseInt(words[3], offset) && parseInt(words[4], limit)) {
+            if (offset < 0 || limit < 0) return false;
+            request.offset = static_cast<size_t>(offset);
+            request.limit = static_cast<size_t>(limit);
+            categoryWord = 5;
+        }
+        if (categoryWord < words.size()) {
+            request.category = string(line.substr(static_cast<size_t>(words[categoryWord].data() - line.data())));
+        }
+        return true;
+    }
+    if ((command == "import" || command == "export") && words.size() > 1) {
+        request.type = command == "import" ? RequestType::Import : RequestType::Export;
+        size_t first = rest.find_first_not_of(" \t");
+        size_t last = rest.find_last_not_of(" \t\r");
+        request.path = string(rest.substr(first, last - first + 1));
+        return true;
+    }
+    if (command == "complete" && words.size() > 1) {
+        request.type = RequestType::Complete;
+        request.words = string(rest);
+        return true;
+    }
+    if (command == "search" && words.size() > 1) {
+        request.type = RequestType::Search;
+        size_t bar = rest.find('|');
+        request.category = string(rest.substr(0, bar));
+        if (bar != string_view::npos) request.words = string(rest.substr(bar + 1));
+        return true;
+    }
+    return false;
+}
+
+// Uzklausos pavadinimas (komanda) trasoms ir ataskaitoms
+const char* requestName(RequestType type) {
+    static const char* const names[] = {"register", "login", "reserve", "cancel", "available", "filter", "search",
+                                        "complete", "years", "hold", "unhold", "import", "export"};
+    return names[static_cast<size_t>(type)];
+}
+
+// Funkcija uzklausai paversti komandos eilute, kuria vel galima isnagrineti su parseRequest.
+// Slaptazodziai nerasomi - vietoje ju "*".
+string formatRequest(const Request& request) {
+    string line = requestName(request.type);
+    auto add = [&](string_view text) {
+        line += ' ';
+        line.append(text.data(), text.size());
+    };
+    // Neribotas kiekis uzrasomas kaip didziausias int (parseRequest kiekius skaito kaip int)
+    auto paging = [&] {
+        add(to_string(request.offset));
+        add(to_string(min<size_t>(request.limit, static_cast<size_t>(numeric_limits<int>::max()))));
+    };
+    switch (request.type) {
+        case RequestType::Register:
+        case RequestType::Login:
+            add(request.user);
+            add("*");
+            break;
+        case RequestType::Reserve:
+        case RequestType::Cancel:
+        case RequestType::Hold:
+        case RequestType::Unhold:
+            if (!request.user.empty()) add(request.user);
+            add(to_string(request.itemID));
+            break;
+        case RequestType::Available:
+            paging();
+            break;
+        case RequestType::Filter:
+            add(request.category);
+            break;
+        case RequestType::Search:
+            add(request.category + "|" + request.words);
+            break;
+        case RequestType::Complete:
+            add(request.words);
+            break;
+        case RequestType::Years:
+            add(to_string(request.fromYear));
+            add(to_string(request.toYear));
+            paging();
+            if (!request.category.empty()) add(request.category);
+            break;
+        case RequestType::Import:
+        case RequestType::Export:
+            add(request.path);
+            break;
+    }
+    return line;
+}
+
+// Sesiju trasa: kiekviena bibliotekai perduota uzklausa irasoma eilute
+// "<mikrosekundes nuo ankstesnio iraso> <sesija> <komanda>". Eilutes kaupiamos buferyje ir
+// rasomos dideliais gabalais; kai trasa isjungta, tikrinama tik viena salyga.
+class TraceRecorder {
+private:
+    static constexpr size_t FlushBytes = 64 * 1024;
+    mutex traceMutex;
+    int fd = -1;
+    string buffer;
+    chrono::steady_clock::time_point last;
+
+public:
+    TraceRecorder() = default;
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    ~TraceRecorder() {
+        close();
+    }
+
+    // Kvieciama pries paleidziant sesijas
+    bool open(const string& path) {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        last = chrono::steady_clock::now();
+        buffer = "# biblioteka trasa 1\n";
+        return fd >= 0;
+    }
+
+    bool enabled() const { return fd >= 0; }
+
+    void record(uint32_t session, const Request& request) {
+        string line = formatRequest(request);
+        lock_guard<mutex> lock(traceMutex);
+        // Laikas imamas uzrakinus, todel skirtumai niekada nebuna neigiami
+        auto now = chrono::steady_clock::now();
+        buffer += to_string(chrono::duration_cast<chrono::microseconds>(now - last).count());
+        last = now;
+        buffer += ' ';
+        buffer += to_string(session);
+        buffer += ' ';
+        buffer += line;
+        buffer += '\n';
+        if (buffer.size() >= FlushBytes) {
+            if (!writeFully(fd, buffer)) cerr << "Klaida: nepavyko irasyti trasos." << endl;
+            buffer.clear();
+        }
+    }
+
+    void close() {
+        lock_guard<mutex> lock(traceMutex);
+        if (fd < 0) return;
+        if (!writeFully(fd, buffer)) cerr << "Klaida: nepavyko irasyti trasos." << endl;
+        buffer.clear();
+        ::close(fd);
+        fd = -1;
+    }
+};
+
+TraceRecorder traceRecorder;
+
+// Sesijos busena: prisijungusio vartotojo vardas (tuscias - neprisijungta)
+struct Session {
+    string user;
+    bool requireLogin = false;  // Serverio sesijose galima veikti tik savo vardu
+    uint32_t id = 0;            // Sesijos numeris trasoje (0 - paketas)
+};
+
+// Serverio sesiju importo ir eksporto katalogas (--transfer-dir); tuscias - serveryje neleidziama
+string transferDirectory;
+
+// Ar vardas - paprastas failo vardas perdavimo kataloge (be katalogu ir ne paslepto failo)
+bool isPlainFileName(const string& name) {
+    return !name.empty() && name[0] != '.' && name.find('/') == string::npos;
+}
+
+// Funkcija uzklausai ivykdyti sesijos kontekste: login isimena vartotoja,
+// o reserve/cancel/hold/unhold be vardo taikomi prisijungusiam vartotojui.
+// Serverio sesijose importuoti ir eksportuoti galima tik prisijungus ir tik
+// failus perdavimo kataloge.
+Result executeInSession(Library& library, Request& request, Session& session) {
+    bool ownsItems = request.type == RequestType::Reserve || request.type == RequestType::Cancel ||
+                     request.type == RequestType::Hold || request.type == RequestType::Unhold;
+    bool transfer = request.type == RequestType::Import || request.type == RequestType::Export;
+    Result result;
+    result.status = Status::AuthFailed;
+    if (ownsItems) {
+        if (request.user.empty()) request.user = session.user;
+        if (request.user.empty() || (session.requireLogin && request.user != session.user)) return result;
+    }
+    if (transfer && session.requireLogin) {
+        if (session.user.empty()) return result;
+        result.status = Status::Forbidden;
+        if (transferDirectory.empty() || !isPlainFileName(request.path)) return result;
+    }
+    if (traceRecorder.enabled()) traceRecorder.record(session.id, request);
+    if (transfer && session.requireLogin) request.path = transferDirectory + "/" + request.path;
+    result = library.execute(request);
+    if (request.type == RequestType::Login && result.status == Status::Ok) session.user = request.user;
+    return result;
+}
+
+// Funkcija rezultatui paversti atsakymo eilute "<busena> [knygu ID...]" (be '\n');
+// EILEJE atveju po busenos nurodoma vieta eileje, importo ir eksporto - eiluciu skaiciai
+void appendResult(string& output, const Result& result) {
+    output += statusText(result.status);
+    if (result.status == Status::Queued) {
+        output += ' ';
+        output += to_string(result.position);
+    }
+    for (size_t count : result.counts) {
+        output += ' ';
+        output += to_string(count);
+    }
+    for (int id : result.itemIDs) {
+        output += ' ';
+        output += to_string(id);
+    }
+}
+
+// Funkcija komandu paketui ivykdyti. Kiekvienai komandai isvedama eilute
+// "<eilutes nr> <busena> [knygu ID...]"; pakeitimus grupemis iraso fonio gija,
+// o pabaigoje laukiama, kol jie bus irasyti.
+// Grazina nepavykusiu komandu skaiciu.
+size_t runBatch(Library& library, istream& in, ostream& out) {
+    auto start = chrono::steady_clock::now();
+    size_t lineNumber = 0, executed = 0, failed = 0;
+    string line, output;
+    Request request;
+    Session session;
+
+    while (getline(in, line)) {
+        ++lineNumber;
+        string_view text(line);
+        size_t first = text.find_first_not_of(" \t\r");
+        if (first == string_view::npos || text[first] == '#') continue;
+
+        output = to_string(lineNumber);
+        if (!parseRequest(text, request)) {
+            output += ' ';
+            output += statusText(Status::InvalidRequest);
+            ++failed;
+        } else {
+            Result result = executeInSession(library, request, session);
+            output += ' ';
+            appendResult(output, result);
+            if (result.status != Status::Ok && result.status != Status::Queued) ++failed;
+        }
+        output += '\n';
+        out << output;
+        ++executed;
+    }
+    library.flush();
+    out.flush();
+
+    auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+    cerr << "Paketas: " << executed << " komandu, " << failed << " nepavyko, " << elapsed.count() << " ms" << endl;
+    return failed;
+}
+
+// Serverio sustabdymo veliava (nustatoma SIGINT/SIGTERM)
+volatile sig_atomic_t stopRequested = 0;
+
+void requestStop(int) {
+    stopRequested = 1;
+}
+
+// Vienos sesijos aptarnavimas: komandos (kaip paketo rezimu) skaitomos is lizdo po eilute,
+// i kiekviena atsakoma eilute "<busena> [knygu ID...]". Komanda quit uzdaro sesija.
+void serveSession(Library& library, int fd, uint32_t id) {
+    const size_t MaxLineBytes = 64 * 1024;
+    Session session;
+    session.requireLogin = true;
+    session.id = id;
+    string pending, output;
+    Request request;
+    char buffer[4096];
+    bool open = true;
+    while (open && !stopRequested) {
+        pollfd pfd{fd, POLLIN, 0};
+        int ready = ::poll(&pfd, 1, 200); // Periodiskai tikrinama sustabdymo veliava
+        if (ready < 0 && errno != EINTR) break;
+        if (ready <= 0) continue;
+        ssize_t n = ::read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        pending.append(buffer, static_cast<size_t>(n));
+
+        output.clear();
+        size_t start = 0, end;
+        while (open && (end = pending.find('\n', start)) != string::npos) {
+            string_view line(pending.data() + start, end - start);
+            start = end + 1;
+            vector<string_view> words = splitWords(line);
+            if (words.empty()) continue;
+            if (words[0] == "quit") {
+                open = false;
+            } else if (!parseRequest(line, request)) {
+                output += statusText(Status::InvalidRequest);
+                output += '\n';
+            } else {
+                appendResult(output, executeInSession(library, request, session));
+                output += '\n';
+            }
+        }
+        pending.erase(0, start);
+        if (pending.size() > MaxLineBytes || !writeFully(fd, output)) break;
+    }
+    ::close(fd);
+}
+
+// Funkcija vietiniam serveriui paleisti Unix lizde. Kiekviena sesija aptarnaujama atskiroje gijoje;
+// darbas baigiamas gavus SIGINT ar SIGTERM, palaukus, kol baigsis visos sesijos.
+int runServer(Library& library, const string& socketPath) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        cerr << "Klaida: per ilgas lizdo kelias " << socketPath << "." << endl;
+        return 1;
+    }
+    memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    int listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        cerr << "Klaida: nepavyko sukurti lizdo: " << strerror(errno) << endl;
+        return 1;
+    }
+    ::unlink(socketPath.c_str()); // Likes nuo ankstesnio paleidimo
+    if (::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listenFd, 128) != 0) {
+        cerr << "Klaida: nepavyko klausytis " << socketPath << ": " << strerror(errno) << endl;
+        ::close(listenFd);
+        return 1;
+    }
+
+    signal(SIGINT, requestStop);
+    signal(SIGTERM, requestStop);
+    signal(SIGPIPE, SIG_IGN); // Nutrukus klientui write grazina klaida, o ne nutraukia procesa
+    cerr << "Serveris klauso " << socketPath << endl;
+
+    atomic<size_t> activeSessions{0};
+    size_t totalSessions = 0;
+    while (!stopRequested) {
+        pollfd pfd{listenFd, POLLIN, 0};
+        int ready = ::poll(&pfd, 1, 200);
+        library.expireOverdue(time(nullptr)); // Pasibaigusios rezervacijos atlaisvinamos ir aptarnaujant
+        if (ready <= 0) continue;
+        int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0) continue;
+        ++activeSessions;
+        ++totalSessions;
+        uint32_t id = static_cast<uint32_t>(totalSessions);
+        thread([&library, &activeSessions, fd, id] {
+            serveSession(library, fd, id);
+            --activeSessions;
+        }).detach();
+    }
+    ::close(listenFd);
+    ::unlink(socketPath.c_str());
+    while (activeSessions > 0) this_thread::sleep_for(chrono::milliseconds(10));
+    cerr << "Serveris sustabdytas, aptarnauta sesiju: " << totalSessions << endl;
+    return 0;
+}
+
+// Skaitytoju mastelio testas: viena gija nuolat rezervuoja ir atsaukia, o skaitytojai per
+// execute() vercia laisvu knygu puslapius. Rasytojas laiko apie puse knygu, todel puslapis
+// nuo pirmo ketvircio turi buti pilnas, o ID - didejantys. Grazina pazeidimu skaiciu.
+size_t runReaderScaling(const vector<size_t>& threadCounts) {
+    const size_t bookCount = 65536;
+    const size_t readsPerThread = 50000;
+    const size_t pageRows = 20;
+    size_t totalViolations = 0;
+
+    Library library(false);
+    int firstID = 0;
+    for (size_t i = 0; i < bookCount; ++i) {
+        int id = library.addBook("Knyga " + to_string(i), "Autorius " + to_string(i % 16), 2000, "Testas");
+        if (i == 0) firstID = id;
+    }
+    library.createUser("rasytojas", "slaptazodis");
+    UserHandle writerUser = library.authenticate("rasytojas", "slaptazodis");
+
+    for (size_t threadCount : threadCounts) {
+        atomic<bool> stop{false};
+        atomic<size_t> violations{0};
+        size_t writes = 0;
+        thread writer([&] {
+            mt19937 rng(7);
+            while (!stop.load(memory_order_relaxed)) {
+                int id = firstID + static_cast<int>(rng() % bookCount);
+                if (library.reserveItem(writerUser, id) != Status::Ok) library.cancelItemReservation(writerUser, id);
+                ++writes;
+            }
+        });
+
+        auto reader = [&](size_t index) {
+            mt19937 rng(static_cast<uint32_t>(index + 1));
+            size_t myViolations = 0;
+            Request request;
+            request.type = RequestType::Available;
+            request.limit = pageRows;
+            for (size_t op = 0; op < readsPerThread; ++op) {
+                request.offset = rng() % (bookCount / 4);
+                Result result = library.execute(request);
+                const vector<int>& ids = result.itemIDs;
+                if (result.status != Status::Ok || ids.size() != pageRows) ++myViolations;
+                for (size_t i = 0; i < ids.size(); ++i) {
+                    if (ids[i] < firstID || ids[i] >= firstID + static_cast<int>(bookCount) ||
+                        (i > 0 && ids[i] <= ids[i - 1])) {
+                        ++myViolations;
+                    }
+                }
+            }
+            violations += myViolations;
+        };
+
+        auto start = chrono::steady_clock::now();
+        vector<thread> threads;
+        for (size_t t = 0; t < threadCount; ++t) threads.emplace_back(reader, t);
+        for (auto& th : threads) th.join();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        stop = true;
+        writer.join();
+
+        size_t reads = threadCount * readsPerThread;
+        cout << "Skaitytojai: " << setw(3) << threadCount
+             << "  puslapiai: " << reads
+             << "  " << fixed << setprecision(0) << reads / seconds << " psl/s"
+             << "  rasymai: " << fixed << setprecision(0) << writes / seconds << " op/s"
+             << "  pazeidimai: " << violations.load() << endl;
+        totalViolations += violations.load();
+    }
+    return totalViolations;
+}
+
+// Apkrovos testas: gijos lenktyniauja del tu paciu knygu (rezervuoja ir atsaukia).
+// Tikrinama, kad knyga niekada neturi dvieju savininku ir kad galutine busena sutampa
+// su prieinamumo bitais; pralaidumas matuojamas didinant giju skaiciu iki maxThreads.
+int runStressTest(size_t maxThreads) {
+    const size_t bookCount = 256;
+    const size_t opsPerThread = 200000;
+    size_t totalViolations = 0;
+    vector<size_t> threadCounts;
+    for (size_t t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    for (size_t threadCount : threadCounts) {
+        Library library(false);
+        int firstID = 0;
+        for (size_t i = 0; i < bookCount; ++i) {
+            int id = library.addBook("Knyga " + to_string(i), "Autorius " + to_string(i % 16), 2000, "Testas");
+            if (i == 0) firstID = id;
+        }
+        for (size_t t = 0; t < threadCount; ++t) library.createUser("vartotojas" + to_string(t), "slaptazodis");
+
+        unique_ptr<atomic<int>[]> holders(new atomic<int>[bookCount]);
+        for (size_t i = 0; i < bookCount; ++i) holders[i] = 0;
+        atomic<size_t> violations{0}, reserved{0}, conflicts{0};
+
+        auto worker = [&](size_t index) {
+            UserHandle self = library.authenticate("vartotojas" + to_string(index), "slaptazodis");
+            mt19937 rng(static_cast<uint32_t>(index + 1));
+            vector<int> mine;
+            size_t myReserved = 0, myConflicts = 0, myViolations = 0;
+            for (size_t op = 0; op < opsPerThread; ++op) {
+                if (!mine.empty() && (rng() & 1)) {
+                    size_t pick = rng() % mine.size();
+                    int id = mine[pick];
+                    mine[pick] = mine.back();
+                    mine.pop_back();
+                    holders[static_cast<size_t>(id - firstID)].fetch_sub(1);
+                    if (library.cancelItemReservation(self, id) != Status::Ok) ++myViolations;
+                } else {
+                    int id = firstID + static_cast<int>(rng() % bookCount);
+                    Status status = library.reserveItem(self, id);
+                    if (status == Status::Ok) {
+                        if (holders[static_cast<size_t>(id - firstID)].fetch_add(1) != 0) ++myViolations;
+                        mine.push_back(id);
+                        ++myReserved;
+                    } else if (status == Status::Unavailable) {
+                        ++myConflicts;
+                    } else {
+                        ++myViolations;
+                    }
+                }
+            }
+            reserved += myReserved;
+            conflicts += myConflicts;
+            violations += myViolations;
+        };
+
+        auto start = chrono::steady_clock::now();
+        vector<thread> threads;
+        for (size_t t = 0; t < threadCount; ++t) threads.emplace_back(worker, t);
+        for (auto& th : threads) th.join();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        // Galutine busena: kiekviena laikoma knyga pazymeta kaip uzimta ir atvirksciai
+        size_t held = 0;
+        for (size_t i = 0; i < bookCount; ++i) {
+            int count = holders[i].load();
+            bool available = library.getCatalog().isAvailable(i);
+            if (count < 0 || count > 1 || available != (count == 0)) ++violations;
+            held += static_cast<size_t>(count);
+        }
+        if (library.countAvailableItems() != bookCount - held) ++violations;
+
+        size_t ops = threadCount * opsPerThread;
+        cout << "Gijos: " << setw(3) << threadCount
+             << "  operacijos: " << ops
+             << "  " << fixed << setprecision(0) << ops / seconds << " op/s"
+             << "  rezervuota: " << reserved.load()
+             << "  uzimta: " << conflicts.load()
+             << "  pazeidimai: " << violations.load() << endl;
+        totalViolations += violations.load();
+    }
+    totalViolations += runReaderScaling(threadCounts);
+    cout << (totalViolations == 0 ? "Apkrovos testas sekmingas." : "Apkrovos testas NEPAVYKO.") << endl;
+    return totalViolations == 0 ? 0 : 1;
+}
+
+// Funkcija sintetiniams duomenims sugeneruoti: books.txt, users.txt ir reservations.txt
+// einamajame kataloge perrasomi, o zurnalas ir library.snap pasalinami. Duomenys (isskyrus datas) deterministiniai.
+int generateLibrary(size_t bookCount, size_t userCount, size_t reservationCount) {
+    static const char* const words[] = {
+        "namai", "kelias", "upe", "miskas", "vejas", "saule", "naktis", "sapnas", "miestas", "jura",
+        "kalnas", "laikas", "zvaigzde", "sesuo", "brolis", "karalius", "paslaptis", "sala", "laivas", "zeme"};
+    static const char* const categories[] = {
+        "Klasika", "Fantastika", "Drama", "Detektyvas", "Poezija", "Istorija", "Mokslas", "Romanas",
+        "Nuotykiai", "Biografija", "Vaikams", "Filosofija", "Siaubas", "Humoras", "Kelione", "Menas"};
+    const size_t wordCount = sizeof(words) / sizeof(words[0]);
+    const size_t categoryCount = sizeof(categories) / sizeof(categories[0]);
+    const size_t authorCount = max<size_t>(1, bookCount / 10);
+    if (userCount == 0) reservationCount = 0;
+    reservationCount = min(reservationCount, bookCount);
+
+    mt19937_64 rng(42);
+    auto title = [&](size_t i) {
+        return string(words[i % wordCount]) + " " + words[(i / wordCount) % wordCount] + " " + to_string(i + 1);
+    };
+    auto flush = [](ofstream& out, string& buffer, bool force) {
+        if (force || buffer.size() >= (1 << 20)) {
+            out << buffer;
+            buffer.clear();
+        }
+    };
+
+    string buffer;
+    vector<uint32_t> authors(bookCount), bookCategories(bookCount);
+    ofstream books("books.txt");
+    for (size_t i = 0; i < bookCount; ++i) {
+        authors[i] = static_cast<uint32_t>(rng() % authorCount + 1);
+        bookCategories[i] = static_cast<uint32_t>(rng() % categoryCount);
+        buffer += title(i) + "|Autorius " + to_string(authors[i]) + "|" + to_string(1500 + rng() % 525) + "|"
+                  + categories[bookCategories[i]] + "\n";
+        flush(books, buffer, false);
+    }
+    flush(books, buffer, true);
+
+    ofstream users("users.txt");
+    for (size_t i = 0; i < userCount; ++i) {
+        buffer += "vartotojas" + to_string(i + 1) + " slaptazodis" + to_string(i + 1) + "\n";
+        flush(users, buffer, false);
+    }
+    flush(users, buffer, true);
+
+    // Kiekviena knyga rezervuojama ne daugiau kaip karta: atsitiktine knygu eiliskumo imtis
+    vector<uint32_t> order(bookCount);
+    for (size_t i = 0; i < bookCount; ++i) order[i] = static_cast<uint32_t>(i);
+    for (size_t i = 0; i < reservationCount; ++i) swap(order[i], order[i + rng() % (bookCount - i)]);
+    // Rezervacijos padarytos per paskutines 5 dienas, todel dar nepasibaigusios
+    time_t now = time(nullptr);
+    ofstream reservations("reservations.txt");
+    for (size_t i = 0; i < reservationCount; ++i) {
+        size_t book = order[i];
+        time_t reservedAt = now - static_cast<time_t>(rng() % (5 * 24 * 60 * 60));
+        buffer += "vartotojas" + to_string(rng() % userCount + 1) + "|" + title(book)
+                  + "|Autorius " + to_string(authors[book]) + "|" + categories[bookCategories[book]]
+                  + "|0|" + formatTime(reservedAt) + "|" + formatTime(reservedAt + Reservation::PickupWindowSeconds) + "\n";
+        flush(reservations, buffer, false);
+    }
+    flush(reservations, buffer, true);
+
+    books.close();
+    users.close();
+    reservations.close();
+    ::unlink("reservations.journal");
+    ::unlink("waitlists.txt");
+    ::unlink("library.snap");
+    if (!books || !users || !reservations) {
+        cerr << "Klaida: nepavyko irasyti sugeneruotu failu." << endl;
+        return 1;
+    }
+    cerr << "Sugeneruota: knygu " << bookCount << ", vartotoju " << userCount
+         << ", rezervaciju " << reservationCount << endl;
+    return 0;
+}
+
+void printBenchmarkHeader() {
+    cout << left << setw(20) << "Operacija" << right << setw(10) << "Kiekis" << setw(14) << "op/s"
+         << setw(11) << "p50 us" << setw(11) << "p90 us" << setw(11) << "p99 us" << setw(12) << "max us" << '\n';
+}
+
+// Matavimu rinkinio eilute: operaciju skaicius, pralaidumas ir velinimo procentiliai (mikrosekundemis).
+// Jei nurodytas units, pralaidumas skaiciuojamas apdorotais vienetais (pvz., eilutemis) per sekunde.
+void reportBenchmark(const char* name, vector<double>& latencies, double seconds, size_t units = 0) {
+    if (latencies.empty()) return;
+    double processed = static_cast<double>(units ? units : latencies.size());
+    sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return latencies[min(latencies.size() - 1, static_cast<size_t>(p * static_cast<double>(latencies.size())))];
+    };
+    cout << left << setw(20) << name << right
+         << setw(10) << latencies.size()
+         << setw(14) << fixed << setprecision(0) << processed / seconds
+         << setprecision(2)
+         << setw(11) << percentile(0.50)
+         << setw(11) << percentile(0.90)
+         << setw(11) << percentile(0.99)
+         << setw(12) << latencies.back() << '\n';
+}
+
+// Matavimu rinkinys einamojo katalogo duomenims: ikelimas (kartu su indeksu rusiavimu),
+// prisijungimas, rezervavimas, atsaukimas, laukimo eile ir paieskos. Duomenys ikeliami i
+// biblioteka atmintyje, todel failai tik perskaitomi - zurnalas ir duomenu failai nekeiciami.
+// Ikelimo eilutese pralaidumas - failo eilutes per sekunde.
+int runBenchmark(size_t operations) {
+    using Clock = chrono::steady_clock;
+    auto micros = [](Clock::time_point from, Clock::time_point to) {
+        return chrono::duration<double, micro>(to - from).count();
+    };
+    // Kiekvienas bandymas matuojamas atskirai; grazinama bendra trukme sekundemis
+    auto measure = [&](vector<double>& latencies, size_t count, auto operation) {
+        latencies.clear();
+        latencies.reserve(count);
+        auto begin = Clock::now();
+        for (size_t i = 0; i < count; ++i) {
+            auto start = Clock::now();
+            operation(i);
+            latencies.push_back(micros(start, Clock::now()));
+        }
+        return chrono::duration<double>(Clock::now() - begin).count();
+    };
+
+    printBenchmarkHeader();
+
+    // Biblioteka atmintyje: matuojant rezervacijos nerasomos i zurnala, failai neperrasomi
+    Library library(false);
+    vector<double> latencies;
+    const CatalogStore& catalog = library.getCatalog();
+    double seconds = measure(latencies, 1, [&](size_t) {
+        library.loadItemsFromFile();
+        library.sortIndexes();
+    });
+    reportBenchmark("loadItems", latencies, seconds, catalog.size());
+    vector<pair<string, string>> credentials;
+    seconds = measure(latencies, 1, [&](size_t) { library.loadUsersFromFile(); });
+    library.forEachUser([&](UserHandle, const User& user) { credentials.emplace_back(user.getName(), user.getPassword()); });
+    reportBenchmark("loadUsers", latencies, seconds, credentials.size());
+    seconds = measure(latencies, 1, [&](size_t) { library.loadReservationsFromFile(); });
+    reportBenchmark("loadReservations", latencies, seconds, catalog.size() - catalog.countAvailable());
+    library.loadWaitlistsFromFile();
+    library.replayJournal();
+
+    const vector<string_view>& categories = catalog.getCategoryNames();
+    cerr << "Knygu " << catalog.size() << ", laisvu " << catalog.countAvailable()
+         << ", vartotoju " << credentials.size() << endl;
+
+    mt19937_64 rng(7);
+    if (!credentials.empty()) {
+        vector<size_t> picks(operations);
+        for (auto& pick : picks) pick = rng() % credentials.size();
+        seconds = measure(latencies, operations, [&](size_t i) {
+            const auto& user = credentials[picks[i]];
+            library.authenticate(user.first, user.second);
+        });
+        reportBenchmark("login", latencies, seconds);
+
+        // Atsitiktines knygos: rezervuotos pirma atsaukiamos, tada visos rezervuojamos,
+        // o is pradziu laisvos vel atsaukiamos
+        vector<int> ids;
+        catalog.forEachRow([&](size_t row) { ids.push_back(catalog.getID(row)); });
+        shuffle(ids.begin(), ids.end(), rng);
+        ids.resize(min(operations, ids.size()));
+        vector<int> reserved, free;
+        vector<UserHandle> reservedOwners, freeOwners;
+        for (int id : ids) {
+            UserHandle holder = library.holderOf(id);
+            if (holder.valid()) {
+                reserved.push_back(id);
+                reservedOwners.push_back(holder);
+            } else {
+                const auto& user = credentials[rng() % credentials.size()];
+                free.push_back(id);
+                freeOwners.push_back(library.authenticate(user.first, user.second));
+            }
+        }
+        vector<double> cancelLatencies;
+        double cancelSeconds = measure(cancelLatencies, reserved.size(), [&](size_t i) {
+            library.cancelItemReservation(reservedOwners[i], reserved[i]);
+        });
+        ids = reserved;
+        ids.insert(ids.end(), free.begin(), free.end());
+        vector<UserHandle> owners = reservedOwners;
+        owners.insert(owners.end(), freeOwners.begin(), freeOwners.end());
+        seconds = measure(latencies, ids.size(), [&](size_t i) { library.reserveItem(owners[i], ids[i]); });
+        reportBenchmark("reserve", latencies, seconds);
+        cancelSeconds += measure(latencies, free.size(), [&](size_t i) { library.cancelItemReservation(freeOwners[i], free[i]); });
+        cancelLatencies.insert(cancelLatencies.end(), latencies.begin(), latencies.end());
+        reportBenchmark("cancel", cancelLatencies, cancelSeconds);
+
+        // Viena populiari knyga: visi vartotojai stoja i jos eile, o po to kiekvienas
+        // atsaukimas perduoda knyga kitam eileje, kol ji vel tampa laisva
+        if (!free.empty() && credentials.size() > 1) {
+            int hot = free[0];
+            library.reserveItem(freeOwners[0], hot);
+            size_t waiters = min(operations, credentials.size());
+            vector<UserHandle> users;
+            for (size_t i = 0; i < waiters; ++i) {
+                users.push_back(library.authenticate(credentials[i].first, credentials[i].second));
             }
+            size_t position;
+            seconds = measure(latencies, waiters, [&](size_t i) { library.holdItem(users[i], hot, position); });
+            reportBenchmark("hold", latencies, seconds);
+            seconds = measure(latencies, waiters + 1, [&](size_t) {
+                library.cancelItemReservation(library.holderOf(hot), hot);
+            });
+            reportBenchmark("promote", latencies, seconds);
         }
     }
+
+    if (!categories.empty()) {
+        size_t filterCount = min<size_t>(operations, 1000);
+        Request request;
+        request.type = RequestType::Filter;
+        seconds = measure(latencies, filterCount, [&](size_t) {
+            request.category = categories[rng() % categories.size()];
+            library.execute(request);
+        });
+        reportBenchmark("filterByCategory", latencies, seconds);
+        request.limit = 20; // Vienas konsoles puslapis
+        seconds = measure(latencies, operations, [&](size_t) {
+            request.category = categories[rng() % categories.size()];
+            library.execute(request);
+        });
+        reportBenchmark("filterPage", latencies, seconds);
+        // Vienas puslapis 50 metu intervale: pusei uzklausu - kartu su zanru
+        request = Request();
+        request.type = RequestType::Years;
+        request.limit = 20;
+        seconds = measure(latencies, operations, [&](size_t i) {
+            request.fromYear = catalog.getYear(rng() % catalog.size());
+            request.toYear = request.fromYear + 49;
+            request.category = i % 2 ? categories[rng() % categories.size()] : string();
+            library.execute(request);
+        });
+        reportBenchmark("yearRange", latencies, seconds);
+    }
+
+    if (catalog.size() > 0) {
+        // Prefiksai - atsitiktiniu pavadinimu pradzios (3 raides), kaip renkant konsoleje
+        vector<string> prefixes;
+        for (size_t i = 0; i < 1000; ++i) prefixes.emplace_back(catalog.getTitle(rng() % catalog.size()).substr(0, 3));
+        Request request;
+        request.type = RequestType::Complete;
+        request.limit = Library::SuggestionLimit;
+        seconds = measure(latencies, operations, [&](size_t i) {
+            request.words = prefixes[i % prefixes.size()];
+            library.execute(request);
+        });
+        reportBenchmark("complete", latencies, seconds);
+    }
+
+    cout.flush();
+    return 0;
+}
+
+// Trasos irasas: laikas nuo trasos pradzios, sesija ir uzklausa
+struct TraceEntry {
+    int64_t micros;
+    uint32_t session;
+    Request request;
 };
 
-int main() {
+// Pakartoja irasyta trasa einamojo katalogo duomenims. Kiekvienas is users imituojamu
+// vartotoju atkartoja viena trasos sesija (ju maziau - sesijos kartojamos is eiles), o
+// uzklausos vykdomos trasos laiku, padalytu is speed (0 - kuo greiciau). Vartotojai
+// paskirstomi gijoms; kiekviena operacija matuojama atskirai, o "velavimas" - kiek
+// operacijos pradzia atsiliko nuo plano. Grazina 0, jei trasa pavyko perskaityti.
+int runReplay(const string& tracePath, double speed, size_t users) {
+    using Clock = chrono::steady_clock;
+    ifstream in(tracePath);
+    if (!in.is_open()) {
+        cerr << "Nepavyko atidaryti trasos " << tracePath << "." << endl;
+        return 1;
+    }
+    vector<TraceEntry> entries;
+    vector<vector<size_t>> sessions;          // Kiekvienos sesijos irasai laiko tvarka
+    unordered_map<uint32_t, size_t> sessionIndex;
+    string line;
+    size_t lineNumber = 0;
+    int64_t micros = 0;
+    while (getline(in, line)) {
+        ++lineNumber;
+        if (line.empty() || line[0] == '#') continue;
+        vector<string_view> words = splitWords(line);
+        int64_t delta = 0;
+        int session = 0;
+        Request request;
+        if (words.size() < 3 || !parseInt(words[0], delta) || !parseInt(words[1], session) || delta < 0 ||
+            session < 0 || !parseRequest(line.substr(static_cast<size_t>(words[2].data() - line.data())), request)) {
+            reportBadLine(tracePath, lineNumber, "netinkamas trasos irasas");
+            continue;
+        }
+        micros += delta;
+        auto found = sessionIndex.emplace(static_cast<uint32_t>(session), sessions.size());
+        if (found.second) sessions.emplace_back();
+        sessions[found.first->second].push_back(entries.size());
+        entries.push_back({micros, static_cast<uint32_t>(session), std::move(request)});
+    }
+    if (entries.empty()) {
+        cerr << "Trasa " << tracePath << " tuscia." << endl;
+        return 1;
+    }
+    if (users == 0) users = sessions.size();
+
+    // Kopija atmintyje: trasos operacijos duomenu failu nekeicia
+    Library library(false);
+    library.load();
+    library.expireOverdue(time(nullptr));
+    // Trasoje slaptazodziu nera: esamu vartotoju prisijungimams imami ju slaptazodziai
+    // (trasoje uzsiregistrave vartotojai turi slaptazodi "*")
+    unordered_map<string, string> passwords;
+    library.forEachUser([&](UserHandle, const User& user) { passwords.emplace(user.getName(), user.getPassword()); });
+    for (TraceEntry& entry : entries) {
+        if (entry.request.type != RequestType::Login) continue;
+        auto it = passwords.find(entry.request.user);
+        if (it != passwords.end()) entry.request.password = it->second;
+    }
+
+    size_t threadCount = min(users, max<size_t>(1, thread::hardware_concurrency()));
+    const size_t typeCount = static_cast<size_t>(RequestType::Export) + 1;
+    struct WorkerStats {
+        vector<double> latencies[typeCount];
+        vector<double> lag;
+        size_t failed = 0;
+    };
+    vector<WorkerStats> stats(threadCount);
+    cerr << "Trasa: " << entries.size() << " uzklausu, " << sessions.size() << " sesiju; imituojamu vartotoju "
+         << users << ", giju " << threadCount << endl;
+
+    auto start = Clock::now() + chrono::milliseconds(10);
+    runParallel(threadCount, [&](size_t worker) {
+        // Gijos vartotoju uzklausos sujungiamos laiko tvarka; vieno vartotojo tvarka islieka
+        struct Step {
+            int64_t micros;
+            size_t user;
+            size_t entry;
+        };
+        vector<Step> steps;
+        vector<Session> userSessions;
+        for (size_t user = worker; user < users; user += threadCount) {
+            Session session;
+            session.id = static_cast<uint32_t>(user);
+            userSessions.push_back(session);
+            for (size_t entry : sessions[user % sessions.size()]) {
+                steps.push_back({entries[entry].micros, userSessions.size() - 1, entry});
+            }
+        }
+        stable_sort(steps.begin(), steps.end(), [](const Step& a, const Step& b) { return a.micros < b.micros; });
+
+        WorkerStats& mine = stats[worker];
+        Request request;
+        for (const Step& step : steps) {
+            Clock::time_point planned = start;
+            if (speed > 0) {
+                planned += chrono::duration_cast<Clock::duration>(
+                    chrono::duration<double, micro>(static_cast<double>(step.micros) / speed));
+            }
+            this_thread::sleep_until(planned);
+            request = entries[step.entry].request;
+            auto begin = Clock::now();
+            Result result = executeInSession(library, request, userSessions[step.user]);
+            auto end = Clock::now();
+            if (result.status != Status::Ok && result.status != Status::Queued) ++mine.failed;
+            mine.latencies[static_cast<size_t>(request.type)].push_back(
+                chrono::duration<double, micro>(end - begin).count());
+            if (speed > 0) mine.lag.push_back(chrono::duration<double, micro>(begin - planned).count());
+        }
+    });
+    double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+    printBenchmarkHeader();
+    size_t total = 0, failed = 0;
+    vector<double> latencies, lag;
+    for (size_t type = 0; type < typeCount; ++type) {
+        latencies.clear();
+        for (WorkerStats& worker : stats) {
+            latencies.insert(latencies.end(), worker.latencies[type].begin(), worker.latencies[type].end());
+        }
+        total += latencies.size();
+        reportBenchmark(requestName(static_cast<RequestType>(type)), latencies, seconds);
+    }
+    for (WorkerStats& worker : stats) {
+        lag.insert(lag.end(), worker.lag.begin(), worker.lag.end());
+        failed += worker.failed;
+    }
+    reportBenchmark("velavimas", lag, seconds);
+    cout.flush();
+    cerr << "Pakartota: " << total << " uzklausu per " << fixed << setprecision(2) << seconds << " s ("
+         << setprecision(0) << static_cast<double>(total) / seconds << " op/s), nepavyko " << failed << endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    JournalConfig journalConfig;
+    string batchPath; // Paketo failas ("-" - standartine ivestis)
+    size_t pageSize = 20;
+    bool poolStats = false; // Ar isvesti telkiniu statistika baigiant darba
+    string socketPath;      // Serverio rezimas: Unix lizdo kelias
+    size_t stressThreads = 0;
+    string convertTarget;   // snapshot arba text
+    string generateSpec;    // KNYGOS,VARTOTOJAI,REZERVACIJOS
+    size_t benchOperations = 0;
+    string metricsPath;     // Metriku failas (tuscias - metrikos isjungtos)
+    size_t metricsInterval = 10;
+    string tracePath;       // Kur irasyti sesiju trasa
+    string replayPath;      // Kuria trasa pakartoti
+    double replaySpeed = 1;
+    size_t replayUsers = 0; // 0 - po viena kiekvienai trasos sesijai
+    string dataDir;         // Duomenu failu katalogas (tuscias - einamasis)
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--fsync=always") {
+            journalConfig.fsyncPolicy = FsyncPolicy::Always;
+        } else if (arg == "--fsync=batch") {
+            journalConfig.fsyncPolicy = FsyncPolicy::Batch;
+        } else if (arg == "--fsync=never") {
+            journalConfig.fsyncPolicy = FsyncPolicy::Never;
+        } else if (arg.rfind("--journal-limit=", 0) == 0) {
+            journalConfig.compactThresholdBytes = stoul(arg.substr(16));
+        } else if (arg.rfind("--page-size=", 0) == 0) {
+            pageSize = stoul(arg.substr(12));
+        } else if (arg == "--pool-stats") {
+            poolStats = true;
+        } else if (arg == "--batch" && i + 1 < argc) {
+            batchPath = argv[++i];
+        } else if (arg == "--serve" && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (arg == "--convert=snapshot" || arg == "--convert=text") {
+            convertTarget = arg.substr(10);
+        } else if (arg.rfind("--metrics=", 0) == 0) {
+            metricsPath = arg.substr(10);
+        } else if (arg.rfind("--metrics-interval=", 0) == 0) {
+            metricsInterval = max<size_t>(1, stoul(arg.substr(19)));
+        } else if (arg.rfind("--trace=", 0) == 0) {
+            tracePath = arg.substr(8);
+        } else if (arg.rfind("--replay=", 0) == 0) {
+            replayPath = arg.substr(9);
+        } else if (arg.rfind("--replay-speed=", 0) == 0) {
+            replaySpeed = max(0.0, stod(arg.substr(15)));
+        } else if (arg.rfind("--replay-users=", 0) == 0) {
+            replayUsers = stoul(arg.substr(15));
+        } else if (arg.rfind("--transfer-dir=", 0) == 0) {
+            transferDirectory = arg.substr(15);
+        } else if (arg.rfind("--data-dir=", 0) == 0) {
+            dataDir = arg.substr(11);
+        } else if (arg.rfind("--generate=", 0) == 0) {
+            generateSpec = arg.substr(11);
+        } else if (arg == "--bench") {
+            benchOperations = 100000;
+        } else if (arg.rfind("--bench=", 0) == 0) {
+            benchOperations = max<size_t>(1, stoul(arg.substr(8)));
+        } else if (arg == "--stress-test") {
+            stressThreads = max<size_t>(1, thread::hardware_concurrency());
+        } else if (arg.rfind("--stress-test=", 0) == 0) {
+            stressThreads = max<size_t>(1, stoul(arg.substr(14)));
+        } else {
+            cerr << "Nezinomas argumentas: " << arg << endl;
+            return 1;
+        }
+    }
+
+    // Visi duomenu failai (ir santykiniai kiti keliai) skaiciuojami nuo duomenu katalogo
+    if (!dataDir.empty() && ::chdir(dataDir.c_str()) != 0) {
+        cerr << "Klaida: nepavyko atidaryti duomenu katalogo " << dataDir << "." << endl;
+        return 1;
+    }
+
+    // Metrikos rasomos periodiskai ir paskutini karta sunaikinant metricsWriter (iseinant)
+    unique_ptr<MetricsWriter> metricsWriter;
+    if (!metricsPath.empty()) {
+        metrics.enable();
+        metricsWriter.reset(new MetricsWriter(metricsPath, chrono::seconds(metricsInterval)));
+    }
+
+    if (stressThreads > 0) return runStressTest(stressThreads);
+    if (!generateSpec.empty()) {
+        size_t counts[3] = {0, 0, 0};
+        size_t field = 0, pos = 0;
+        for (; field < 3 && pos <= generateSpec.size(); ++field) {
+            size_t comma = generateSpec.find(',', pos);
+            string part = generateSpec.substr(pos, comma == string::npos ? string::npos : comma - pos);
+            int value;
+            if (!parseInt(part, value) || value < 0) break;
+            counts[field] = static_cast<size_t>(value);
+            pos = comma == string::npos ? generateSpec.size() + 1 : comma + 1;
+        }
+        if (field != 3 || pos <= generateSpec.size()) {
+            cerr << "Klaida: --generate=KNYGOS,VARTOTOJAI,REZERVACIJOS" << endl;
+            return 1;
+        }
+        return generateLibrary(counts[0], counts[1], counts[2]);
+    }
+    if (benchOperations > 0) return runBenchmark(benchOperations);
+    if (!replayPath.empty()) return runReplay(replayPath, replaySpeed, replayUsers);
+    if (!tracePath.empty() && !traceRecorder.open(tracePath)) {
+        cerr << "Klaida: nepavyko sukurti trasos failo " << tracePath << "." << endl;
+        return 1;
+    }
+
     Library library;
-    library.loadUsersFromFile();
-    library.loadReservationsFromFile();
+    library.setJournalConfig(journalConfig);
+    library.load();
+    size_t expired = library.expireOverdue(time(nullptr));
+    if (expired > 0) cerr << "Atlaisvinta pasibaigusiu rezervaciju: " << expired << endl;
+
+    if (!convertTarget.empty()) {
+        StorageFormat format = convertTarget == "snapshot" ? StorageFormat::Snapshot : StorageFormat::Text;
+        if (!library.convertTo(format)) {
+            cerr << "Klaida: nepavyko konvertuoti duomenu." << endl;
+            return 1;
+        }
+        cerr << "Duomenys issaugoti " << (format == StorageFormat::Snapshot ? "library.snap" : "tekstiniuose failuose")
+             << ": knygu " << library.getCatalog().size() << endl;
+        return 0;
+    }
+
+    if (!socketPath.empty()) {
+        int status = runServer(library, socketPath);
+        library.save();
+        if (poolStats) library.printPoolStats(cerr);
+        return status;
+    }
+
+    if (!batchPath.empty()) {
+        if (batchPath == "-") {
+            runBatch(library, cin, cout);
+        } else {
+            ifstream batchFile(batchPath);
+            if (!batchFile.is_open()) {
+                cerr << "Nepavyko atidaryti paketo failo " << batchPath << "." << endl;
+                return 1;
+            }
+            runBatch(library, batchFile, cout);
+        }
+        library.save();
+        if (poolStats) library.printPoolStats(cerr);
+        return 0;
+    }
+
+    LibraryConsole console(library, pageSize);
     int choice;
 
     do {
+        library.expireOverdue(time(nullptr));
         printTitle("Prisijungimo Sistema");
         cout << "1. Prisijungti\n";
         cout << "2. Registruotis\n";
@@ -560,6 +5688,7 @@ int main() {
         cin >> choice;
 
         if (cin.fail()) {
+            if (cin.eof()) break; // Ivestis baigesi - issaugome ir iseiname
             cin.clear();
             cin.ignore(numeric_limits<streamsize>::max(), '\n');
             cout << "Klaida: pasirinkimas turi buti skaicius nuo 1 iki 4." << endl;
@@ -567,37 +5696,41 @@ int main() {
         }
 
         switch (choice) {
-            case 1: library.loginUser(); break;
-            case 2: library.registerUser(); break;
+            case 1: console.loginUser(); break;
+            case 2: console.registerUser(); break;
             case 3: {
                 int action;
                 do {
+                    library.expireOverdue(time(nullptr));
                     printTitle("Bibliotekos Sistema");
                     cout << "1. Perziureti visas knygas\n";
                     cout << "2. Perziureti laisvas knygas\n";
-                    cout << "3. Filtruoti pagal zanra\n";
-                    cout << "4. Rezervuoti knyga\n";
-                    cout << "5. Grizti i pagrindini meniu\n";
+                    cout << "3. Filtruoti pagal zanra ir metus\n";
+                    cout << "4. Ieskoti pagal zanra ir zodzius\n";
+                    cout << "5. Rezervuoti knyga\n";
+                    cout << "6. Grizti i pagrindini meniu\n";
                     printLine();
                     cout << "Pasirinkimas: ";
                     cin >> action;
 
                     if (cin.fail()) {
+                        if (cin.eof()) break; // Ivestis baigesi
                         cin.clear();
                         cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                        cout << "Klaida: pasirinkimas turi buti skaicius nuo 1 iki 5." << endl;
+                        cout << "Klaida: pasirinkimas turi buti skaicius nuo 1 iki 6." << endl;
                         continue;
                     }
 
                     switch (action) {
-                        case 1: library.displayItems(); break;
-                        case 2: library.displayAvailableItems(); break;
-                        case 3: library.filterByCategory(); break;
-                        case 4: library.makeReservation(); break;
-                        case 5: cout << "Griztate i pagrindini meniu." << endl; break;
-                        default: cout << "Klaida: pasirinkimas turi buti nuo 1 iki 5." << endl;
+                        case 1: console.displayItems(); break;
+                        case 2: console.displayAvailableItems(); break;
+                        case 3: console.filterByCategory(); break;
+                        case 4: console.searchCatalog(); break;
+                        case 5: console.makeReservation(); break;
+                        case 6: cout << "Griztate i pagrindini meniu." << endl; break;
+                        default: cout << "Klaida: pasirinkimas turi buti nuo 1 iki 6." << endl;
                     }
-                } while (action != 5);
+                } while (action != 6);
                 break;
             }
             case 4: cout << "Aciu, kad naudojotes musu sistema!" << endl; break;
@@ -605,7 +5738,7 @@ int main() {
         }
     } while (choice != 4);
 
-    library.saveUsersToFile();
-    library.saveReservationsToFile();
+    library.save(); // Barjeras: laukiama, kol fonio gija viska irasys
+    if (poolStats) library.printPoolStats(cerr);
     return 0;
 }